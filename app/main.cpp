@@ -1,12 +1,25 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <type_traits>
+#include <variant>
+#include <unistd.h>
 #include <KeyValuePairExtractorBuilder.h>
+#include <impl/CountingMemoryResource.h>
+#include <impl/SchemaInference.h>
+#include <impl/serializer/ArrowStreamWriter.h>
+#include <impl/serializer/CsvSerializer.h>
+#include <impl/serializer/LogfmtSerializer.h>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <impl/serializer/TsvSerializer.h>
+#include <util/ReadBufferFromFileDescriptor.h>
+#include <util/RecordReader.h>
+#include <util/WriteBufferFromFileDescriptor.h>
 #include <argparse/argparse.hpp>
 
 struct Arguments
 {
-    // if input is too big, this is a problem
-    // a stream would be a better approach
-    // might be empty in case input_path is set
+    // A single record given on the command line. Without it records are streamed from input_path, or from stdin
     std::optional<std::string> input;
 
     std::optional<std::string> input_path;
@@ -19,29 +32,113 @@ struct Arguments
 
     std::optional<char> quoting_character;
 
+    char record_delimiter = '\n';
+
+    std::string format = "ndjson";
+
+    std::optional<std::vector<std::string>> columns;
+
+    uint32_t batch_size = 65536;
+
+    std::vector<std::string> low_cardinality_columns;
+
+    uint32_t max_dictionary_size = extractKV::ColumnarBatch::DEFAULT_MAX_DICTIONARY_SIZE;
+
+    std::vector<std::pair<std::string, extractKV::ValueType>> column_types;
+
     std::optional<uint32_t> max_number_of_pairs;
 
+    std::optional<std::vector<std::string>> filters;
+
     bool escape = false;
 
+    bool validate = false;
+
+    bool infer_schema = false;
+
+    double sample_fraction = 1.0;
+
+    uint64_t sample_size = 100000;
+
+    bool diagnostics = false;
+
+    bool stats = false;
+
+    bool latency = false;
+
     bool verbose = false;
 };
 
+char parse_delimiter(const std::string & delimiter)
+{
+    if (delimiter == "\\n")
+    {
+        return '\n';
+    }
+
+    if (delimiter == "\\t")
+    {
+        return '\t';
+    }
+
+    if (delimiter == "\\0")
+    {
+        return '\0';
+    }
+
+    if (delimiter.size() != 1)
+    {
+        throw std::runtime_error ("Invalid arguments, record delimiter must be a single character: " + delimiter);
+    }
+
+    return delimiter[0];
+}
+
 auto parse_arguments(int argc, char * argv[])
 {
     Arguments arguments;
 
     argparse::ArgumentParser program("key_value_pair_extractor");
 
-    program.add_argument("-i", "--input").help("Raw ASCII string");
-    program.add_argument("-f", "--file").help("Path to file containing raw ASCII string");
-    program.add_argument("-o", "--output").help("Path to output file");
+    program.add_argument("-i", "--input").help("Raw ASCII string, extracted as a single record");
+    program.add_argument("-f", "--file").help("Path to file containing records, stdin is read if neither --input nor --file is set");
+    program.add_argument("-o", "--output").help("Path to output file, stdout if not set");
+    program.add_argument("-rd", "--record-delimiter").help("Separates records from each other, a new line by default. Accepts \\n, \\t and \\0");
+    program.add_argument("--format").help("Output format: ndjson (default), csv, tsv, logfmt or arrow (IPC stream)");
+    program.add_argument("--columns").nargs(0, 99)
+    .help("Keys written as columns by the csv, tsv and arrow formats, in order. Without it arrow writes a single map column");
+    program.add_argument("--batch-size").scan<'u', uint32_t>().help("Maximum number of rows per arrow record batch, 65536 by default");
+    program.add_argument("--low-cardinality").nargs(0, 99)
+    .help("Columns with few distinct values, dictionary encoded by the arrow format. Must be listed in --columns as well");
+    program.add_argument("--max-dictionary-size").scan<'u', uint32_t>()
+    .help("Low cardinality columns with more distinct values in the first batch are written as plain strings, 8192 by default");
+    program.add_argument("--types").nargs(0, 99)
+    .help("Types of columns parsed by the arrow format, as key:type with type int64, double, bool or timestamp. Invalid values are null");
     program.add_argument("-kvd", "--key-value-delimiter").help("Key-value delimiter, sits between key and value");
     program.add_argument("-itd", "--item-delimiters").nargs(0, 99).help("Item delimiters, separates pairs from each other. Multiple values are allowed");
     program.add_argument("-q", "--quoting-character").help("Character used for quoting");
     program.add_argument("-e", "--escape").flag().help("Enable escape sequences");
     program.add_argument("-mnp", "--max-number-of-pairs")
     .scan<'u', uint32_t>()
-    .help("Maximum number of key-value pairs to extract. Helpful to avoid memory exhaustion in case of a corrupted input file");
+    .help("Maximum number of key-value pairs per record, records with more are skipped. Helpful to avoid memory exhaustion in case of "
+          "a corrupted input file");
+    program.add_argument("--filter").nargs(0, 99)
+    .help("Keep only rows matching all predicates: key=value, key!=value, key (present) or !key (absent). Multiple values are allowed. "
+          "A repeated key is matched by its first occurrence, while the output keeps its last value");
+    program.add_argument("--validate").flag()
+    .help("Only count pairs and report malformed regions, without extracting keys and values");
+    program.add_argument("--infer-schema").flag()
+    .help("Only extract a sample of the records and print the inferred --columns, --types and --low-cardinality, key statistics to stderr");
+    program.add_argument("--sample-fraction").scan<'g', double>()
+    .help("Fraction of the records sampled by --infer-schema, evenly spread over the input, 1 by default");
+    program.add_argument("--sample-size").scan<'u', uint64_t>()
+    .help("Records sampled by --infer-schema before it stops reading, 100000 by default");
+    program.add_argument("--diagnostics").flag()
+    .help("Report dropped tokens with their reason, byte offsets and a sample of the offending input to stderr");
+    program.add_argument("--stats").flag()
+    .help("Report the allocations and bytes allocated per extraction, and the highest peak of live bytes of an extraction, to stderr");
+    program.add_argument("--latency").flag()
+    .help("Report p50, p99 and p999 extraction latencies to stderr");
     program.add_argument("-v", "--verbose").default_value(false).implicit_value(true).help("Verbose mode");
 
     try {
@@ -69,6 +166,52 @@ auto parse_arguments(int argc, char * argv[])
         arguments.output_path = program.get("output");
     }
 
+    if (program.present("record-delimiter"))
+    {
+        arguments.record_delimiter = parse_delimiter(program.get("record-delimiter"));
+    }
+
+    if (program.present("format"))
+    {
+        arguments.format = program.get("format");
+    }
+
+    if (program.present("columns"))
+    {
+        arguments.columns = program.get<std::vector<std::string>>("columns");
+    }
+
+    if (program.present<uint32_t>("batch-size"))
+    {
+        arguments.batch_size = program.get<uint32_t>("batch-size");
+    }
+
+    if (program.present("low-cardinality"))
+    {
+        arguments.low_cardinality_columns = program.get<std::vector<std::string>>("low-cardinality");
+    }
+
+    if (program.present<uint32_t>("max-dictionary-size"))
+    {
+        arguments.max_dictionary_size = program.get<uint32_t>("max-dictionary-size");
+    }
+
+    if (program.present("types"))
+    {
+        for (const auto & column_type : program.get<std::vector<std::string>>("types"))
+        {
+            const auto separator = column_type.rfind(':');
+
+            if (separator == std::string::npos)
+            {
+                throw std::runtime_error ("Invalid arguments, expected key:type in --types, got '" + column_type + "'");
+            }
+
+            arguments.column_types.emplace_back(column_type.substr(0, separator),
+                                                extractKV::parseValueType(std::string_view(column_type).substr(separator + 1)));
+        }
+    }
+
     if (program.present("key-value-delimiter"))
     {
         arguments.key_value_delimiter = program.get<std::string>("key-value-delimiter")[0];
@@ -94,17 +237,47 @@ auto parse_arguments(int argc, char * argv[])
         arguments.max_number_of_pairs = program.get<uint32_t>("max-number-of-pairs");
     }
 
+    if (program.present("filter"))
+    {
+        arguments.filters = program.get<std::vector<std::string>>("filter");
+    }
+
     arguments.escape = program.get<bool>("escape");
 
+    arguments.validate = program.get<bool>("validate");
+
+    arguments.infer_schema = program.get<bool>("infer-schema");
+
+    if (program.present<double>("sample-fraction"))
+    {
+        arguments.sample_fraction = program.get<double>("sample-fraction");
+    }
+
+    if (program.present<uint64_t>("sample-size"))
+    {
+        arguments.sample_size = program.get<uint64_t>("sample-size");
+    }
+
+    arguments.diagnostics = program.get<bool>("diagnostics");
+
+    arguments.stats = program.get<bool>("stats");
+
+    arguments.latency = program.get<bool>("latency");
+
     arguments.verbose = program.get<bool>("verbose");
 
     return arguments;
 }
 
-auto make_extractor(const Arguments & program_arguments)
+auto make_extractor(const Arguments & program_arguments, std::shared_ptr<extractKV::LatencyHistogram> latency_histogram)
 {
     auto builder = KeyValuePairExtractorBuilder();
 
+    if (latency_histogram)
+    {
+        builder.withLatencyHistogram(std::move(latency_histogram));
+    }
+
     if (program_arguments.key_value_delimiter.has_value())
     {
         builder.withKeyValueDelimiter(program_arguments.key_value_delimiter.value());
@@ -125,6 +298,14 @@ auto make_extractor(const Arguments & program_arguments)
         builder.withMaxNumberOfPairs(program_arguments.max_number_of_pairs.value());
     }
 
+    if (program_arguments.filters.has_value())
+    {
+        for (const auto & filter : program_arguments.filters.value())
+        {
+            builder.withFilter(filter);
+        }
+    }
+
     if (program_arguments.escape)
     {
         builder.withEscaping();
@@ -133,52 +314,523 @@ auto make_extractor(const Arguments & program_arguments)
     return builder.build();
 }
 
+// Verbose output goes to stderr, so that it does not end up among the records written to stdout
 void print_program_arguments(const auto & arguments)
 {
-    std::cout<<"Program arguments: \n";
-    std::cout<<"Input: "<<arguments.input.value_or("not set")<<"\n";
-    std::cout<<"Input path: "<<arguments.input_path.value_or("not set")<<"\n";
-    std::cout<<"Output path: "<<arguments.output_path.value_or("not set")<<"\n";
+    std::cerr<<"Program arguments: \n";
+    std::cerr<<"Input: "<<arguments.input.value_or("not set")<<"\n";
+    std::cerr<<"Input path: "<<arguments.input_path.value_or("not set")<<"\n";
+    std::cerr<<"Output path: "<<arguments.output_path.value_or("not set")<<"\n";
 }
 
 void print_extractor_configuration(const auto & configuration)
 {
-    std::cout<<"Extractor configuration:\n";
-    std::cout<<"Key-value delimiter: "<<configuration.key_value_delimiter<<"\n";
-    std::cout<<"Item delimiters: ";
+    std::cerr<<"Extractor configuration:\n";
+    std::cerr<<"Key-value delimiter: "<<configuration.key_value_delimiter<<"\n";
+    std::cerr<<"Item delimiters: ";
     for (const auto & item : configuration.pair_delimiters)
     {
-        std::cout<<item<<" ";
+        std::cerr<<item<<" ";
     }
-    std::cout<<"\n";
-    std::cout<<"Quoting character: "<<configuration.quoting_character<<"\n";
+    std::cerr<<"\n";
+    std::cerr<<"Quoting character: "<<configuration.quoting_character<<"\n";
 }
 
-int main(int argc, char * argv[])
+void print_diagnostics(const extractKV::Diagnostics & diagnostics)
+{
+    std::cerr << "Dropped tokens: " << diagnostics.numberOfEvents() << "\n";
+
+    for (const auto & [event, snippet] : diagnostics.samples())
+    {
+        std::cerr << extractKV::StateHandler::toString(event.reason) << " row " << event.row << " [" << event.begin << ", " << event.end
+                  << "): " << snippet << "\n";
+    }
+}
+
+/*
+ * Allocations of every extraction, measured separately with `CountingMemoryResource::resetStats`.
+ * */
+struct ExtractionStats
+{
+    uint64_t extractions = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t max_peak_live_bytes = 0;
+
+    void add(const extractKV::CountingMemoryResource::Stats & stats)
+    {
+        ++extractions;
+        allocations += stats.allocations;
+        bytes_allocated += stats.bytes_allocated;
+        max_peak_live_bytes = std::max(max_peak_live_bytes, stats.peak_live_bytes);
+    }
+};
+
+void print_stats(const ExtractionStats & stats)
+{
+    const auto per_extraction = [&](uint64_t total)
+    {
+        return stats.extractions ? static_cast<double>(total) / static_cast<double>(stats.extractions) : 0.0;
+    };
+
+    std::cerr << "Extractions: " << stats.extractions << "\n";
+    std::cerr << "Allocations per extraction: " << per_extraction(stats.allocations) << "\n";
+    std::cerr << "Bytes allocated per extraction: " << per_extraction(stats.bytes_allocated) << "\n";
+    std::cerr << "Max peak live bytes of an extraction: " << stats.max_peak_live_bytes << "\n";
+}
+
+void print_latency(const extractKV::LatencyHistogram::Snapshot & snapshot)
+{
+    std::cerr << "Extractions: " << snapshot.count() << "\n";
+    std::cerr << "p50: " << snapshot.percentile(0.5) << " ns\n";
+    std::cerr << "p99: " << snapshot.percentile(0.99) << " ns\n";
+    std::cerr << "p999: " << snapshot.percentile(0.999) << " ns\n";
+}
+
+/*
+ * Calls `callback` for every record of the input: the `--input` string as a single record, or the records of `--file` or stdin, read
+ * through one reusable buffer so that memory stays bounded by the buffer and the longest record. A callback returning `bool` stops
+ * reading by returning false.
+ * */
+void for_each_record(const Arguments & program_arguments, auto && callback)
+{
+    if (program_arguments.input.has_value())
+    {
+        callback(std::string_view(program_arguments.input.value()));
+        return;
+    }
+
+    std::unique_ptr<ReadBufferFromFileDescriptor> in;
+
+    if (program_arguments.input_path.has_value())
+    {
+        in = std::make_unique<ReadBufferFromFile>(program_arguments.input_path.value());
+    }
+    else
+    {
+        in = std::make_unique<ReadBufferFromFileDescriptor>(STDIN_FILENO);
+    }
+
+    RecordReader reader(*in, program_arguments.record_delimiter);
+    std::string_view record;
+
+    while (reader.next(record))
+    {
+        if constexpr (std::is_same_v<decltype(callback(record)), bool>)
+        {
+            if (!callback(record))
+            {
+                return;
+            }
+        }
+        else
+        {
+            callback(record);
+        }
+    }
+}
+
+void write_validation_result(uint64_t record_number, std::string_view record, const KeyValuePairExtractor::ValidationResult & result,
+                             WriteBuffer & out)
 {
-    auto program_arguments = parse_arguments(argc, argv);
+    out.write("Record " + std::to_string(record_number) + ": " + std::to_string(result.number_of_pairs) + " pairs\n");
+
+    for (const auto & [begin, end, reason] : result.malformed_regions)
+    {
+        out.write(extractKV::StateHandler::toString(reason));
+        out.write(" [" + std::to_string(begin) + ", " + std::to_string(end) + "): ");
+        out.write(record.substr(begin, end - begin));
+        out.write('\n');
+    }
+}
+
+using Serializer = std::variant<extractKV::NdjsonSerializer, extractKV::CsvSerializer, extractKV::TsvSerializer, extractKV::LogfmtSerializer>;
+
+Serializer make_serializer(const Arguments & program_arguments)
+{
+    const auto & format = program_arguments.format;
+
+    if (format == "ndjson")
+    {
+        return extractKV::NdjsonSerializer();
+    }
+
+    if (format == "logfmt")
+    {
+        return extractKV::LogfmtSerializer();
+    }
+
+    if (format == "csv" || format == "tsv")
+    {
+        if (!program_arguments.columns.has_value())
+        {
+            throw std::runtime_error ("Invalid arguments, --format " + format + " requires --columns");
+        }
+
+        if (format == "csv")
+        {
+            return Serializer(std::in_place_type<extractKV::CsvSerializer>, program_arguments.columns.value());
+        }
 
-    auto extractor = make_extractor(program_arguments);
+        return Serializer(std::in_place_type<extractKV::TsvSerializer>, program_arguments.columns.value());
+    }
+
+    throw std::runtime_error ("Invalid arguments, unknown output format " + format);
+}
+
+void extract_records(const Arguments & program_arguments, const KeyValuePairExtractor & extractor, auto & serializer, WriteBuffer & out)
+{
+    if (program_arguments.stats && program_arguments.diagnostics)
+    {
+        throw std::runtime_error ("Invalid arguments, --stats and --diagnostics can't be combined");
+    }
+
+    serializer.writeHeader(out);
+
+    uint64_t dropped_records = 0;
+    uint64_t rejected_records = 0;
+    extractKV::Diagnostics diagnostics;
+
+    // A record that exceeds a limit, e.g. a corrupted line, is skipped instead of ending the whole stream
+    auto write_or_drop = [&](const std::expected<bool, KeyValuePairExtractor::ExtractionError> & kept, const auto & map)
+    {
+        if (!kept)
+        {
+            ++rejected_records;
+        }
+        else if (kept.value())
+        {
+            serializer.writeRow(map, out);
+        }
+        else
+        {
+            ++dropped_records;
+        }
+    };
+
+    if (program_arguments.stats)
+    {
+        extractKV::CountingMemoryResource counting_resource;
+        KeyValuePairExtractor::PmrResponse map(&counting_resource);
+        ExtractionStats stats;
+
+        for_each_record(program_arguments, [&](std::string_view record)
+        {
+            counting_resource.resetStats();
+            const auto kept = extractor.tryExtract(record, map);
+            stats.add(counting_resource.getStats());
+
+            write_or_drop(kept, map);
+        });
+
+        out.finalize();
+
+        print_stats(stats);
+    }
+    else
+    {
+        KeyValuePairExtractor::Response map;
+
+        for_each_record(program_arguments, [&](std::string_view record)
+        {
+            const auto kept = program_arguments.diagnostics
+                ? extractor.tryExtract(record, map, diagnostics)
+                : extractor.tryExtract(record, map);
+
+            write_or_drop(kept, map);
+        });
+
+        out.finalize();
+    }
 
-    // todo add a proper logger that takes logger level and compares against global verbosity level
     if (program_arguments.verbose)
     {
-        print_program_arguments(program_arguments);
-        print_extractor_configuration(extractor->getConfiguration());
+        std::cerr << "Records dropped by filter: " << dropped_records << "\n";
+        std::cerr << "Records rejected by limits: " << rejected_records << "\n";
+    }
+
+    if (program_arguments.diagnostics)
+    {
+        print_diagnostics(diagnostics);
+    }
+}
+
+/*
+ * Pairs go straight into the columns of a batch, which is written out once it holds `batch_size` rows or a lot of data, so that
+ * neither memory nor the 32 bit offsets of the columns grow with the input, or once a dictionary of a low cardinality column is full.
+ * */
+void extract_records_to_arrow(const Arguments & program_arguments, const KeyValuePairExtractor & extractor, WriteBuffer & out)
+{
+    static constexpr size_t MAX_BATCH_DATA_SIZE = 256 << 20;
+
+    if (program_arguments.stats || program_arguments.diagnostics)
+    {
+        throw std::runtime_error ("Invalid arguments, --stats and --diagnostics are not supported with --format arrow");
+    }
+
+    if (program_arguments.batch_size == 0)
+    {
+        throw std::runtime_error ("Invalid arguments, --batch-size must be positive");
+    }
+
+    if (!program_arguments.columns.has_value()
+        && (!program_arguments.low_cardinality_columns.empty() || !program_arguments.column_types.empty()))
+    {
+        throw std::runtime_error ("Invalid arguments, --low-cardinality and --types require --columns");
+    }
+
+    auto batch = program_arguments.columns.has_value()
+        ? extractKV::ColumnarBatch(program_arguments.columns.value(), program_arguments.low_cardinality_columns,
+                                   program_arguments.max_dictionary_size, program_arguments.column_types)
+        : extractKV::ColumnarBatch();
+
+    extractKV::ArrowStreamWriter writer(out);
+    uint64_t dropped_records = 0;
+    uint64_t rejected_records = 0;
+
+    // Values of typed columns that couldn't be parsed, per column
+    std::vector<uint64_t> invalid_values(batch.isMap() ? 0 : batch.getColumnNames().size());
+
+    auto write_batch = [&]
+    {
+        writer.write(batch);
+
+        for (size_t i = 0; i < invalid_values.size(); ++i)
+        {
+            if (batch.getType(i) != extractKV::ValueType::STRING)
+            {
+                invalid_values[i] += batch.getTypedColumn(i).invalid_count;
+            }
+        }
+
+        batch.clear();
+    };
+
+    for_each_record(program_arguments, [&](std::string_view record)
+    {
+        // A record that exceeds a limit is left out of the batch
+        if (const auto kept = extractor.tryExtract(record, batch); !kept)
+        {
+            ++rejected_records;
+        }
+        else if (!kept.value())
+        {
+            ++dropped_records;
+        }
 
-        std::cout << "--------------------------------\n";
+        if (batch.numberOfRows() == program_arguments.batch_size || batch.dataSize() >= MAX_BATCH_DATA_SIZE || batch.isFull())
+        {
+            write_batch();
+        }
+    });
 
-        std::cout << "Starting extraction...\n";
+    if (batch.numberOfRows())
+    {
+        write_batch();
+    }
+
+    writer.finish(batch);
+    out.finalize();
+
+    if (program_arguments.verbose)
+    {
+        std::cerr << "Records dropped by filter: " << dropped_records << "\n";
+        std::cerr << "Records rejected by limits: " << rejected_records << "\n";
 
-        std::cout << "--------------------------------\n";
+        for (size_t i = 0; i < invalid_values.size(); ++i)
+        {
+            if (batch.getType(i) != extractKV::ValueType::STRING)
+            {
+                std::cerr << "Invalid " << extractKV::valueTypeName(batch.getType(i)) << " values of " << batch.getColumnNames()[i] << ": "
+                          << invalid_values[i] << "\n";
+            }
+        }
     }
+}
 
-    auto map = extractor->extract(program_arguments.input.value());
+/*
+ * Extracts an evenly spread fraction of the records, at most `sample_size` of them, and prints the schema inferred from them as
+ * arguments for `--format arrow`, e.g. `--columns ts level latency --types ts:timestamp latency:double --low-cardinality level`. The
+ * statistics behind it go to stderr, one line per key.
+ * */
+void infer_schema(const Arguments & program_arguments, const KeyValuePairExtractor & extractor, WriteBuffer & out)
+{
+    static constexpr size_t ROWS_PER_BATCH = 4096;
 
-    for (const auto & [key, value] : map)
+    if (!(program_arguments.sample_fraction > 0 && program_arguments.sample_fraction <= 1) || program_arguments.sample_size == 0)
     {
-        std::cout<<key << ":" << value <<"\n";
+        throw std::runtime_error ("Invalid arguments, --sample-fraction must be in (0, 1] and --sample-size positive");
     }
 
-    return 1;
+    extractKV::ColumnarBatch batch;
+    extractKV::SchemaInference inference;
+    uint64_t record_number = 0;
+    uint64_t sampled_records = 0;
+
+    for_each_record(program_arguments, [&](std::string_view record)
+    {
+        // Every record where the running count of sampled records, `record_number * sample_fraction`, reaches the next integer
+        const auto sampled_so_far = static_cast<uint64_t>(static_cast<double>(record_number++) * program_arguments.sample_fraction);
+
+        if (static_cast<uint64_t>(static_cast<double>(record_number) * program_arguments.sample_fraction) == sampled_so_far)
+        {
+            return true;
+        }
+
+        // Rows dropped by the filter or rejected by a limit don't count towards the schema
+        extractor.tryExtract(record, batch);
+
+        if (batch.numberOfRows() == ROWS_PER_BATCH)
+        {
+            inference.add(batch);
+            batch.clear();
+        }
+
+        return ++sampled_records < program_arguments.sample_size;
+    });
+
+    inference.add(batch);
+
+    const auto columns = inference.getColumns();
+
+    std::cerr << "Sampled records: " << sampled_records << ", rows: " << inference.numberOfRows() << "\n";
+    std::cerr << "key\tpresence\ttype\tmin_length\tmax_length\tdistinct_values\n";
+
+    for (const auto & column : columns)
+    {
+        std::cerr << column.key << "\t" << column.presence << "\t" << extractKV::valueTypeName(column.type)
+                  << (column.low_cardinality ? " (low cardinality)" : "") << "\t" << column.min_length << "\t" << column.max_length << "\t"
+                  << static_cast<uint64_t>(std::llround(column.distinct_values)) << "\n";
+    }
+
+    std::string columns_argument = "--columns";
+    std::string types_argument;
+    std::string low_cardinality_argument;
+
+    for (const auto & column : columns)
+    {
+        columns_argument += " " + column.key;
+
+        if (column.type != extractKV::ValueType::STRING)
+        {
+            types_argument += " " + column.key + ":" + std::string(extractKV::valueTypeName(column.type));
+        }
+
+        if (column.low_cardinality)
+        {
+            low_cardinality_argument += " " + column.key;
+        }
+    }
+
+    out.write(columns_argument);
+
+    if (!types_argument.empty())
+    {
+        out.write(" --types" + types_argument);
+    }
+
+    if (!low_cardinality_argument.empty())
+    {
+        out.write(" --low-cardinality" + low_cardinality_argument);
+    }
+
+    out.write('\n');
+    out.finalize();
+}
+
+int run(const Arguments & program_arguments, const KeyValuePairExtractor & extractor)
+{
+    const bool arrow = program_arguments.format == "arrow";
+    auto serializer = arrow ? Serializer() : make_serializer(program_arguments);
+
+    std::unique_ptr<WriteBufferFromFileDescriptor> out;
+
+    if (program_arguments.output_path.has_value())
+    {
+        out = std::make_unique<WriteBufferFromFile>(program_arguments.output_path.value());
+    }
+    else
+    {
+        out = std::make_unique<WriteBufferFromFileDescriptor>(STDOUT_FILENO);
+    }
+
+    if (program_arguments.validate)
+    {
+        KeyValuePairExtractor::ValidationResult result;
+        uint64_t record_number = 0;
+
+        for_each_record(program_arguments, [&](std::string_view record)
+        {
+            extractor.validate(record, result);
+            write_validation_result(record_number++, record, result, *out);
+        });
+
+        out->finalize();
+
+        return 0;
+    }
+
+    if (program_arguments.infer_schema)
+    {
+        infer_schema(program_arguments, extractor, *out);
+        return 0;
+    }
+
+    if (arrow)
+    {
+        extract_records_to_arrow(program_arguments, extractor, *out);
+        return 0;
+    }
+
+    // Dispatch on the format once, the loop over the records is instantiated for every serializer
+    std::visit([&](auto & concrete_serializer) { extract_records(program_arguments, extractor, concrete_serializer, *out); }, serializer);
+
+    return 0;
+}
+
+int main(int argc, char * argv[])
+{
+    // Invalid arguments throw as well, while parsing them or configuring the extractor
+    try
+    {
+        auto program_arguments = parse_arguments(argc, argv);
+
+        auto latency_histogram = program_arguments.latency ? std::make_shared<extractKV::LatencyHistogram>() : nullptr;
+
+        auto extractor = make_extractor(program_arguments, latency_histogram);
+
+        // Reported on every exit path below
+        struct LatencyReport
+        {
+            std::shared_ptr<extractKV::LatencyHistogram> histogram;
+
+            ~LatencyReport()
+            {
+                if (histogram)
+                {
+                    print_latency(histogram->snapshot());
+                }
+            }
+        } latency_report {latency_histogram};
+
+        // todo add a proper logger that takes logger level and compares against global verbosity level
+        if (program_arguments.verbose)
+        {
+            print_program_arguments(program_arguments);
+            print_extractor_configuration(extractor->getConfiguration());
+
+            std::cerr << "--------------------------------\n";
+
+            std::cerr << "Starting extraction...\n";
+
+            std::cerr << "--------------------------------\n";
+        }
+
+        return run(program_arguments, *extractor);
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
 }
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+#include <impl/serializer/ArrowStreamWriter.h>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <util/WriteBufferFromString.h>
+
+/*
+ * Extracting rows and writing them out: `BM_ResponseToNdjson` goes through a `Response` per row and `NdjsonSerializer`, the Arrow variants
+ * append the pairs straight to a `ColumnarBatch` and write it as an IPC record batch, in the map and in the projected layout.
+ * `BM_ArrowLowCardinality` dictionary encodes the repetitive columns, `output_bytes` shows the size of the stream.
+ * */
+namespace
+{
+    constexpr auto NUMBER_OF_ROWS = 4096u;
+
+    const std::vector<std::string> & rows()
+    {
+        static const auto data = []
+        {
+            std::vector<std::string> result;
+
+            for (size_t row = 0; row < NUMBER_OF_ROWS; ++row)
+            {
+                result.emplace_back("ts:" + std::to_string(1700000000 + row) + " level:info user:user_" + std::to_string(row % 97)
+                                    + " latency:" + std::to_string(row % 1000) + " msg:\"request served\"");
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    int64_t bytesPerIteration()
+    {
+        int64_t size = 0;
+
+        for (const auto & row : rows())
+        {
+            size += static_cast<int64_t>(row.size());
+        }
+
+        return size;
+    }
+
+    void writeArrow(benchmark::State & state, extractKV::ColumnarBatch batch)
+    {
+        auto extractor = KeyValuePairExtractorBuilder().build();
+        WriteBufferFromString out(1 << 20);
+
+        for (auto _ : state)
+        {
+            out.clear();
+            batch.clear();
+
+            for (const auto & row : rows())
+            {
+                extractor->extract(row, batch);
+            }
+
+            extractKV::ArrowStreamWriter writer(out);
+            writer.write(batch);
+            writer.finish(batch);
+
+            benchmark::DoNotOptimize(out.str().data());
+        }
+
+        state.SetBytesProcessed(state.iterations() * bytesPerIteration());
+        state.counters["output_bytes"] = static_cast<double>(out.str().size());
+    }
+}
+
+static void BM_ResponseToNdjson(benchmark::State & state)
+{
+    auto extractor = KeyValuePairExtractorBuilder().build();
+    KeyValuePairExtractor::Response response;
+    WriteBufferFromString out(1 << 20);
+
+    for (auto _ : state)
+    {
+        out.clear();
+
+        for (const auto & row : rows())
+        {
+            extractor->extract(row, response);
+            extractKV::NdjsonSerializer::writeRow(response, out);
+        }
+
+        benchmark::DoNotOptimize(out.str().data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytesPerIteration());
+}
+BENCHMARK(BM_ResponseToNdjson);
+
+static void BM_ArrowMap(benchmark::State & state)
+{
+    writeArrow(state, extractKV::ColumnarBatch());
+}
+BENCHMARK(BM_ArrowMap);
+
+static void BM_ArrowProjected(benchmark::State & state)
+{
+    writeArrow(state, extractKV::ColumnarBatch({"ts", "level", "user", "latency", "msg"}));
+}
+BENCHMARK(BM_ArrowProjected);
+
+static void BM_ArrowLowCardinality(benchmark::State & state)
+{
+    writeArrow(state, extractKV::ColumnarBatch({"ts", "level", "user", "latency", "msg"}, {"level", "user", "msg"}));
+}
+BENCHMARK(BM_ArrowLowCardinality);
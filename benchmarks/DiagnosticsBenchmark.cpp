@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Extraction of dirty rows with and without `extractKV::Diagnostics`. Rows without diagnostics run the same code as before they
+ * existed, the gap is the cost of recording the dropped tokens.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t i = 0; i < 64; ++i)
+            {
+                result += "key_" + std::to_string(i) + ":value_" + std::to_string(i) + (i % 8 ? " " : " broken,");
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+}
+
+static void BM_ExtractWithoutDiagnostics(benchmark::State & state)
+{
+    const auto extractor = KeyValuePairExtractorBuilder().build();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor->extract(input(), response));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_ExtractWithoutDiagnostics);
+
+static void BM_ExtractWithDiagnostics(benchmark::State & state)
+{
+    const auto extractor = KeyValuePairExtractorBuilder().build();
+
+    KeyValuePairExtractor::Response response;
+    extractKV::Diagnostics diagnostics;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor->extract(input(), response, diagnostics));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_ExtractWithDiagnostics);
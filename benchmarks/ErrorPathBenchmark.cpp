@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Dirty rows that exceed the pair limit, reported as an exception by `extract` and as a value by `tryExtract`. The gap is the cost of
+ * unwinding, which also grows with the number of threads hitting it.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = "a:1 b:2 c:3 d:4 e:5 f:6 g:7 h:8";
+        return data;
+    }
+
+    const KeyValuePairExtractor & extractor()
+    {
+        static const auto instance = KeyValuePairExtractorBuilder().withMaxNumberOfPairs(4).build();
+        return *instance;
+    }
+
+    void threadCounts(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->ThreadRange(1, 4)->UseRealTime();
+    }
+}
+
+static void BM_ThrowingExtract(benchmark::State & state)
+{
+    KeyValuePairExtractor::Response response;
+    size_t errors = 0;
+
+    for (auto _ : state)
+    {
+        try
+        {
+            extractor().extract(input(), response);
+        }
+        catch (const std::runtime_error &)
+        {
+            ++errors;
+        }
+    }
+
+    benchmark::DoNotOptimize(errors);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_ThrowingExtract)->Apply(threadCounts);
+
+static void BM_TryExtract(benchmark::State & state)
+{
+    KeyValuePairExtractor::Response response;
+    size_t errors = 0;
+
+    for (auto _ : state)
+    {
+        if (!extractor().tryExtract(input(), response))
+        {
+            ++errors;
+        }
+    }
+
+    benchmark::DoNotOptimize(errors);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_TryExtract)->Apply(threadCounts);
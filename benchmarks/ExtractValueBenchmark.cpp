@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Looking up one key close to the end of a long row, with `extractValue` and by extracting the whole row.
+ * */
+namespace
+{
+    std::string makeRow(size_t number_of_pairs)
+    {
+        std::string row;
+
+        for (size_t i = 0; i < number_of_pairs; ++i)
+        {
+            row += "field_" + std::to_string(i) + ":value_" + std::to_string(i * 17) + " ";
+        }
+
+        return row + "request_id:3f2a9c request_time:17";
+    }
+
+    void rowSizes(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->RangeMultiplier(4)->Range(16, 1024);
+    }
+}
+
+static void BM_ExtractValue(benchmark::State & state)
+{
+    const auto row = makeRow(state.range(0));
+    const auto extractor = KeyValuePairExtractorBuilder().build();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor->extractValue(row, "request_id"));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * row.size()));
+}
+BENCHMARK(BM_ExtractValue)->Apply(rowSizes);
+
+static void BM_ExtractWholeRow(benchmark::State & state)
+{
+    const auto row = makeRow(state.range(0));
+    const auto extractor = KeyValuePairExtractorBuilder().build();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        extractor->extract(row, response);
+        benchmark::DoNotOptimize(response.find("request_id"));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * row.size()));
+}
+BENCHMARK(BM_ExtractWholeRow)->Apply(rowSizes);
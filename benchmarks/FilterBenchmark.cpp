@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+#include <vector>
+
+/*
+ * Keeping the 1% of rows with `level=ERROR`, by filtering while extracting and by extracting every row and filtering afterwards.
+ * */
+namespace
+{
+    std::vector<std::string> makeRows()
+    {
+        std::vector<std::string> rows;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            std::string row = "ts=" + std::to_string(1700000000 + i) + " level=" + (i % 100 == 0 ? "ERROR" : "INFO");
+
+            for (size_t j = 0; j < 16; ++j)
+            {
+                row += " field_" + std::to_string(j) + "=value_" + std::to_string(i * j);
+            }
+
+            rows.push_back(std::move(row));
+        }
+
+        return rows;
+    }
+}
+
+static void BM_FilterWhileExtracting(benchmark::State & state)
+{
+    const auto rows = makeRows();
+    const auto extractor = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').withFilter("level=ERROR").build();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        size_t kept = 0;
+
+        for (const auto & row : rows)
+        {
+            kept += extractor->extract(row, response);
+        }
+
+        benchmark::DoNotOptimize(kept);
+    }
+}
+BENCHMARK(BM_FilterWhileExtracting);
+
+static void BM_FilterAfterExtracting(benchmark::State & state)
+{
+    const auto rows = makeRows();
+    const auto extractor = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').build();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        size_t kept = 0;
+
+        for (const auto & row : rows)
+        {
+            extractor->extract(row, response);
+
+            const auto level = response.find("level");
+            kept += level != response.end() && level->second == "ERROR";
+        }
+
+        benchmark::DoNotOptimize(kept);
+    }
+}
+BENCHMARK(BM_FilterAfterExtracting);
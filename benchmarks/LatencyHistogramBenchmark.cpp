@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Overhead of recording every extraction into a shared `extractKV::LatencyHistogram`. Recording is two clock reads and a relaxed
+ * increment on a per thread shard, so it should not stop scaling with threads.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t i = 0; i < 32; ++i)
+            {
+                result += "key_" + std::to_string(i) + ":value_" + std::to_string(i * 31) + ", ";
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    const KeyValuePairExtractor & untimedExtractor()
+    {
+        static const auto extractor = KeyValuePairExtractorBuilder().build();
+        return *extractor;
+    }
+
+    const KeyValuePairExtractor & timedExtractor()
+    {
+        static const auto extractor = KeyValuePairExtractorBuilder().withLatencyHistogram(std::make_shared<extractKV::LatencyHistogram>()).build();
+        return *extractor;
+    }
+
+    void threadCounts(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->ThreadRange(1, 16)->UseRealTime();
+    }
+}
+
+static void BM_WithoutLatencyHistogram(benchmark::State & state)
+{
+    const auto & extractor = untimedExtractor();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor.extract(input(), response));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_WithoutLatencyHistogram)->Apply(threadCounts);
+
+static void BM_WithLatencyHistogram(benchmark::State & state)
+{
+    const auto & extractor = timedExtractor();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor.extract(input(), response));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_WithLatencyHistogram)->Apply(threadCounts);
@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+#include <impl/CountingMemoryResource.h>
+
+#include <array>
+
+/*
+ * One fresh response per row, as in a service extracting each request on its own. `BM_HeapResponse` allocates every node and string
+ * from the global heap, `BM_ArenaResponse` from a `std::pmr::monotonic_buffer_resource` on the stack that is thrown away with the row.
+ *
+ * `BM_AllocationsPerRow` reports what one extraction allocates, through `extractKV::CountingMemoryResource`, with and without
+ * escaping, for a fresh response and for a reused one. Allocation regressions show up in its counters.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                result += "some_longer_key_" + std::to_string(i) + ":\"quoted value number " + std::to_string(i * 31) + "\" ";
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    const KeyValuePairExtractor & extractor()
+    {
+        static const auto instance = KeyValuePairExtractorBuilder().withEscaping().build();
+        return *instance;
+    }
+
+    void threadCounts(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->ThreadRange(1, 4)->UseRealTime();
+    }
+}
+
+static void BM_HeapResponse(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        KeyValuePairExtractor::Response response;
+        benchmark::DoNotOptimize(extractor().extract(input(), response));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_HeapResponse)->Apply(threadCounts);
+
+static void BM_ArenaResponse(benchmark::State & state)
+{
+    std::array<std::byte, 16 * 1024> buffer;
+
+    for (auto _ : state)
+    {
+        std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+        KeyValuePairExtractor::PmrResponse response(&arena);
+        benchmark::DoNotOptimize(extractor().extract(input(), response));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_ArenaResponse)->Apply(threadCounts);
+
+static void BM_AllocationsPerRow(benchmark::State & state)
+{
+    const bool with_escaping = state.range(0);
+    const bool reuse_response = state.range(1);
+
+    auto builder = KeyValuePairExtractorBuilder();
+
+    if (with_escaping)
+    {
+        builder.withEscaping();
+    }
+
+    const auto counted_extractor = builder.build();
+
+    extractKV::CountingMemoryResource counting_resource;
+    KeyValuePairExtractor::PmrResponse reused_response(&counting_resource);
+
+    extractKV::CountingMemoryResource::Stats total;
+
+    for (auto _ : state)
+    {
+        counting_resource.resetStats();
+
+        if (reuse_response)
+        {
+            benchmark::DoNotOptimize(counted_extractor->extract(input(), reused_response));
+        }
+        else
+        {
+            KeyValuePairExtractor::PmrResponse response(&counting_resource);
+            benchmark::DoNotOptimize(counted_extractor->extract(input(), response));
+        }
+
+        const auto & stats = counting_resource.getStats();
+        total.allocations += stats.allocations;
+        total.bytes_allocated += stats.bytes_allocated;
+        total.peak_live_bytes = std::max(total.peak_live_bytes, stats.peak_live_bytes);
+    }
+
+    const auto iterations = static_cast<double>(state.iterations());
+
+    state.counters["allocations_per_row"] = static_cast<double>(total.allocations) / iterations;
+    state.counters["bytes_per_row"] = static_cast<double>(total.bytes_allocated) / iterations;
+    state.counters["peak_live_bytes"] = static_cast<double>(total.peak_live_bytes);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_AllocationsPerRow)->ArgNames({"escaping", "reuse"})->ArgsProduct({{0, 1}, {0, 1}});
@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+#include <vector>
+
+/*
+ * Log lines that repeat the same key sequence, with and without the `RowShape` check done by `KeyValuePairExtractorHandle`.
+ * `BM_ChangingRowShape` shuffles the key order on every row, which shows the cost of the checks until the shape gets disabled.
+ * */
+namespace
+{
+    std::vector<std::string> makeRows(bool same_shape)
+    {
+        const std::vector<std::string> keys {"ts", "level", "msg", "user", "latency", "request_id", "status", "bytes"};
+
+        std::vector<std::string> rows;
+
+        for (size_t i = 0; i < 1024; ++i)
+        {
+            std::string row;
+
+            for (size_t j = 0; j < keys.size(); ++j)
+            {
+                const auto & key = keys[same_shape ? j : (j + i) % keys.size()];
+                row += key + "=" + std::to_string(i * 131 + j) + " ";
+            }
+
+            rows.push_back(std::move(row));
+        }
+
+        return rows;
+    }
+
+    size_t totalSize(const std::vector<std::string> & rows)
+    {
+        size_t size = 0;
+
+        for (const auto & row : rows)
+        {
+            size += row.size();
+        }
+
+        return size;
+    }
+}
+
+static void BM_SameRowShapeWithoutCheck(benchmark::State & state)
+{
+    const auto rows = makeRows(true);
+    const auto extractor = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').build();
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        for (const auto & row : rows)
+        {
+            extractor->extract(row, response);
+            benchmark::DoNotOptimize(&response);
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * totalSize(rows)));
+}
+BENCHMARK(BM_SameRowShapeWithoutCheck);
+
+static void BM_SameRowShape(benchmark::State & state)
+{
+    const auto rows = makeRows(true);
+    auto handle = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').buildHandleWithoutEscaping();
+
+    for (auto _ : state)
+    {
+        for (const auto & row : rows)
+        {
+            benchmark::DoNotOptimize(&handle.extract(row));
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * totalSize(rows)));
+}
+BENCHMARK(BM_SameRowShape);
+
+static void BM_ChangingRowShape(benchmark::State & state)
+{
+    const auto rows = makeRows(false);
+    auto handle = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').buildHandleWithoutEscaping();
+
+    for (auto _ : state)
+    {
+        for (const auto & row : rows)
+        {
+            benchmark::DoNotOptimize(&handle.extract(row));
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * totalSize(rows)));
+}
+BENCHMARK(BM_ChangingRowShape);
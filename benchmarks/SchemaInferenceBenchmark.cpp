@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+#include <impl/SchemaInference.h>
+
+/*
+ * Cost of the schema inference pass per sampled row, extraction into a map layout batch included. `BM_ExtractOnly` is the same
+ * extraction without collecting statistics, the difference is the cost of type checks and distinct count estimates.
+ * */
+namespace
+{
+    constexpr auto NUMBER_OF_ROWS = 4096u;
+
+    const std::vector<std::string> & rows()
+    {
+        static const auto data = []
+        {
+            std::vector<std::string> result;
+
+            for (size_t row = 0; row < NUMBER_OF_ROWS; ++row)
+            {
+                result.emplace_back("ts:2024-01-01T00:00:" + std::to_string(10 + row % 50) + "Z level:info user:user_"
+                                    + std::to_string(row % 97) + " status:" + std::to_string(200 + row % 5 * 100)
+                                    + " latency:" + std::to_string(row % 1000) + ".5 msg:\"request served\"");
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    void extractSample(benchmark::State & state, bool infer)
+    {
+        auto extractor = KeyValuePairExtractorBuilder().build();
+        extractKV::ColumnarBatch batch;
+
+        for (auto _ : state)
+        {
+            extractKV::SchemaInference inference;
+            batch.clear();
+
+            for (const auto & row : rows())
+            {
+                extractor->extract(row, batch);
+            }
+
+            if (infer)
+            {
+                inference.add(batch);
+                benchmark::DoNotOptimize(inference.getColumns());
+            }
+
+            benchmark::DoNotOptimize(batch.numberOfRows());
+        }
+
+        state.SetItemsProcessed(state.iterations() * NUMBER_OF_ROWS);
+    }
+}
+
+static void BM_ExtractOnly(benchmark::State & state)
+{
+    extractSample(state, false);
+}
+BENCHMARK(BM_ExtractOnly);
+
+static void BM_SchemaInference(benchmark::State & state)
+{
+    extractSample(state, true);
+}
+BENCHMARK(BM_SchemaInference);
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <KeyValuePairExtractorBuilder.h>
+#include <impl/serializer/CsvSerializer.h>
+#include <impl/serializer/LogfmtSerializer.h>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <impl/serializer/TsvSerializer.h>
+#include <util/WriteBufferFromString.h>
+
+/*
+ * Cost of writing extracted rows, per format, against `BM_Ostream`: the `key:value` loop over `std::ostream` the CLI used to have.
+ * Values are mostly clean with an occasional quote, so the serializers spend their time in `find_first_symbols` and `memcpy`.
+ * */
+namespace
+{
+    constexpr auto NUMBER_OF_COLUMNS = 16u;
+
+    const KeyValuePairExtractor::Response & row()
+    {
+        static const auto response = []
+        {
+            KeyValuePairExtractor::Response result;
+
+            for (size_t i = 0; i < NUMBER_OF_COLUMNS; ++i)
+            {
+                result["key_" + std::to_string(i)] = "a somewhat longer value number " + std::to_string(i) + (i % 4 ? "" : " with \"quotes\"");
+            }
+
+            return result;
+        }();
+
+        return response;
+    }
+
+    std::vector<std::string> columns()
+    {
+        std::vector<std::string> result;
+
+        for (size_t i = 0; i < NUMBER_OF_COLUMNS; ++i)
+        {
+            result.push_back("key_" + std::to_string(i));
+        }
+
+        return result;
+    }
+
+    size_t rowSize()
+    {
+        size_t size = 0;
+
+        for (const auto & [key, value] : row())
+        {
+            size += key.size() + value.size();
+        }
+
+        return size;
+    }
+
+    template <typename Serializer>
+    void serialize(benchmark::State & state, Serializer serializer)
+    {
+        WriteBufferFromString out(1 << 16);
+
+        for (auto _ : state)
+        {
+            out.clear();
+            serializer.writeRow(row(), out);
+            benchmark::DoNotOptimize(out.str().data());
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * rowSize()));
+    }
+}
+
+static void BM_Ostream(benchmark::State & state)
+{
+    std::ostringstream out;
+
+    for (auto _ : state)
+    {
+        out.seekp(0);
+
+        for (const auto & [key, value] : row())
+        {
+            out << key << ":" << value << "\n";
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * rowSize()));
+}
+BENCHMARK(BM_Ostream);
+
+static void BM_Ndjson(benchmark::State & state)
+{
+    serialize(state, extractKV::NdjsonSerializer());
+}
+BENCHMARK(BM_Ndjson);
+
+static void BM_Csv(benchmark::State & state)
+{
+    serialize(state, extractKV::CsvSerializer(columns()));
+}
+BENCHMARK(BM_Csv);
+
+static void BM_Tsv(benchmark::State & state)
+{
+    serialize(state, extractKV::TsvSerializer(columns()));
+}
+BENCHMARK(BM_Tsv);
+
+static void BM_Logfmt(benchmark::State & state)
+{
+    serialize(state, extractKV::LogfmtSerializer());
+}
+BENCHMARK(BM_Logfmt);
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <util/ReadBufferFromMemory.h>
+#include <util/RecordReader.h>
+#include <util/WriteBufferFromFileDescriptor.h>
+
+/*
+ * Throughput of the streaming CLI path: split lines out of a buffer, extract every record and write it as NDJSON to /dev/null.
+ * `BM_StreamRecordsFlushingEveryRecord` writes every record with its own `write` call, which is what an unbuffered (or line buffered)
+ * output costs, the difference to `BM_StreamRecords` is the saving of the buffered writer.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t row = 0; row < 10000; ++row)
+            {
+                for (size_t i = 0; i < 8; ++i)
+                {
+                    result += "key_" + std::to_string(i) + ":value_" + std::to_string(row * i) + " ";
+                }
+
+                result += "message:\"quoted text\"\n";
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    void streamRecords(benchmark::State & state, bool flush_every_record)
+    {
+        const int fd = ::open("/dev/null", O_WRONLY);
+        auto extractor = KeyValuePairExtractorBuilder().build();
+        KeyValuePairExtractor::Response response;
+
+        for (auto _ : state)
+        {
+            ReadBufferFromMemory in(input().data(), input().size());
+            RecordReader reader(in, '\n');
+            WriteBufferFromFileDescriptor out(fd);
+            std::string_view record;
+
+            while (reader.next(record))
+            {
+                extractor->extract(record, response);
+                extractKV::NdjsonSerializer::writeRow(response, out);
+
+                if (flush_every_record)
+                {
+                    out.next();
+                }
+            }
+
+            out.finalize();
+        }
+
+        ::close(fd);
+
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+    }
+}
+
+static void BM_StreamRecords(benchmark::State & state)
+{
+    streamRecords(state, false);
+}
+BENCHMARK(BM_StreamRecords);
+
+static void BM_StreamRecordsFlushingEveryRecord(benchmark::State & state)
+{
+    streamRecords(state, true);
+}
+BENCHMARK(BM_StreamRecordsFlushingEveryRecord);
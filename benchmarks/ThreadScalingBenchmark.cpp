@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+#include <array>
+
+/*
+ * Scaling of one extractor shared by an increasing number of threads. Ideally `BM_SharedExtractor` scales like `BM_PerThreadExtractor`,
+ * any gap points at shared mutable state (false sharing) inside the extractor.
+ *
+ * `BM_SharedExtractorCopyingSharedPtr` shows the cost of copying the `std::shared_ptr` on every call, where all threads hammer the same
+ * reference count. `BM_PerThreadCountersAdjacent` and `BM_PerThreadCountersPadded` write per thread results next to each other or on
+ * separate cache lines, the difference between the two is the cost of false sharing on this machine.
+ * */
+namespace
+{
+    constexpr auto MAX_THREADS = 64u;
+
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t i = 0; i < 32; ++i)
+            {
+                result += "key_" + std::to_string(i) + ":value_" + std::to_string(i * 31) + ", ";
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    const KeyValuePairExtractor & sharedExtractor()
+    {
+        static const auto extractor = KeyValuePairExtractorBuilder().build();
+        return *extractor;
+    }
+
+    const std::shared_ptr<KeyValuePairExtractor> & sharedExtractorPointer()
+    {
+        static const auto extractor = KeyValuePairExtractorBuilder().build();
+        return extractor;
+    }
+
+    void threadCounts(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->ThreadRange(1, 16)->UseRealTime();
+    }
+
+    std::array<uint64_t, MAX_THREADS> adjacent_counters;
+
+    struct alignas(64) PaddedCounter
+    {
+        uint64_t value;
+    };
+
+    std::array<PaddedCounter, MAX_THREADS> padded_counters;
+}
+
+static void BM_SharedExtractor(benchmark::State & state)
+{
+    const auto & extractor = sharedExtractor();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor.extract(input()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_SharedExtractor)->Apply(threadCounts);
+
+static void BM_SharedExtractorCopyingSharedPtr(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        auto extractor = sharedExtractorPointer();
+        benchmark::DoNotOptimize(extractor->extract(input()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_SharedExtractorCopyingSharedPtr)->Apply(threadCounts);
+
+static void BM_PerThreadExtractor(benchmark::State & state)
+{
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(extractor->extract(input()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_PerThreadExtractor)->Apply(threadCounts);
+
+static void BM_PerThreadCountersAdjacent(benchmark::State & state)
+{
+    const auto & extractor = sharedExtractor();
+    auto & counter = adjacent_counters[state.thread_index()];
+
+    for (auto _ : state)
+    {
+        counter += extractor.extract(input()).size();
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_PerThreadCountersAdjacent)->Apply(threadCounts);
+
+static void BM_PerThreadCountersPadded(benchmark::State & state)
+{
+    const auto & extractor = sharedExtractor();
+    auto & counter = padded_counters[state.thread_index()].value;
+
+    for (auto _ : state)
+    {
+        counter += extractor.extract(input()).size();
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_PerThreadCountersPadded)->Apply(threadCounts);
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Per call overhead on tiny inputs (16 - 256 bytes), e.g. request headers. Compares the virtual `std::shared_ptr` API, which needs
+ * a `std::string` and returns a fresh map, with `KeyValuePairExtractorHandle`, which takes a `std::string_view` and reuses its map.
+ * */
+namespace
+{
+    std::string makeInput(size_t size)
+    {
+        std::string input;
+
+        for (size_t i = 0; input.size() < size; ++i)
+        {
+            input += "k" + std::to_string(i) + ":v" + std::to_string(i * 7) + " ";
+        }
+
+        input.resize(size);
+
+        return input;
+    }
+
+    void tinyInputSizes(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->RangeMultiplier(2)->Range(16, 256);
+    }
+}
+
+static void BM_SharedPtrExtractor(benchmark::State & state)
+{
+    const auto input = makeInput(state.range(0));
+    const char * raw_input = input.c_str();
+
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    for (auto _ : state)
+    {
+        // Callers holding `const char *` have to materialize a `std::string` first.
+        auto response = extractor->extract(std::string(raw_input));
+        benchmark::DoNotOptimize(response);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_SharedPtrExtractor)->Apply(tinyInputSizes);
+
+static void BM_ExtractorHandle(benchmark::State & state)
+{
+    const auto input = makeInput(state.range(0));
+    const char * raw_input = input.c_str();
+
+    auto handle = KeyValuePairExtractorBuilder().buildHandleWithoutEscaping();
+
+    for (auto _ : state)
+    {
+        const auto & response = handle.extract(raw_input);
+        benchmark::DoNotOptimize(&response);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_ExtractorHandle)->Apply(tinyInputSizes);
+
+static void BM_ExtractorHandleWithEscaping(benchmark::State & state)
+{
+    const auto input = makeInput(state.range(0));
+    const char * raw_input = input.c_str();
+
+    auto handle = KeyValuePairExtractorBuilder().buildHandleWithEscaping();
+
+    for (auto _ : state)
+    {
+        const auto & response = handle.extract(raw_input);
+        benchmark::DoNotOptimize(&response);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_ExtractorHandleWithEscaping)->Apply(tinyInputSizes);
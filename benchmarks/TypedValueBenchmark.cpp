@@ -0,0 +1,134 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+#include <charconv>
+
+/*
+ * Numeric conversion of extracted values. `BM_ParseInt64` compares the SWAR digit conversion of `extractKV::parseInt64` with
+ * `std::from_chars` on integers of 1 to 19 digits. `BM_ResponseThenParse` is what consumers do today, extract a `Response` and convert
+ * its strings, `BM_TypedColumns` parses the values into typed `ColumnarBatch` columns during extraction.
+ * */
+namespace
+{
+    constexpr auto NUMBER_OF_VALUES = 4096u;
+
+    const std::vector<std::string> & integers()
+    {
+        static const auto data = []
+        {
+            std::vector<std::string> result;
+            uint64_t value = 1;
+
+            for (size_t i = 0; i < NUMBER_OF_VALUES; ++i)
+            {
+                value = value * 6364136223846793005ull + 1442695040888963407ull;
+                result.push_back(std::to_string((value >> 1) >> (i % 63)));
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    const std::vector<std::string> & rows()
+    {
+        static const auto data = []
+        {
+            std::vector<std::string> result;
+
+            for (size_t row = 0; row < NUMBER_OF_VALUES; ++row)
+            {
+                result.emplace_back("ts:" + std::to_string(1700000000 + row) + " status:" + std::to_string(200 + row % 5 * 100)
+                                    + " bytes:" + std::to_string(row * 7919) + " latency:" + std::to_string(row % 1000) + ".5 cached:"
+                                    + (row % 2 ? "true" : "false"));
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+}
+
+static void BM_ParseInt64(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        for (const auto & value : integers())
+        {
+            int64_t result;
+            benchmark::DoNotOptimize(extractKV::parseInt64(value, result));
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUMBER_OF_VALUES);
+}
+BENCHMARK(BM_ParseInt64);
+
+static void BM_FromCharsInt64(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        for (const auto & value : integers())
+        {
+            int64_t result;
+            benchmark::DoNotOptimize(std::from_chars(value.data(), value.data() + value.size(), result));
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUMBER_OF_VALUES);
+}
+BENCHMARK(BM_FromCharsInt64);
+
+static void BM_ResponseThenParse(benchmark::State & state)
+{
+    auto extractor = KeyValuePairExtractorBuilder().build();
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        for (const auto & row : rows())
+        {
+            extractor->extract(row, response);
+
+            benchmark::DoNotOptimize(std::stoll(response.at("ts")));
+            benchmark::DoNotOptimize(std::stoll(response.at("status")));
+            benchmark::DoNotOptimize(std::stoll(response.at("bytes")));
+            benchmark::DoNotOptimize(std::stod(response.at("latency")));
+            benchmark::DoNotOptimize(response.at("cached") == "true");
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUMBER_OF_VALUES);
+}
+BENCHMARK(BM_ResponseThenParse);
+
+static void BM_TypedColumns(benchmark::State & state)
+{
+    using extractKV::ValueType;
+
+    auto extractor = KeyValuePairExtractorBuilder().build();
+    const std::vector<std::pair<std::string, ValueType>> types {
+        {"ts", ValueType::TIMESTAMP}, {"status", ValueType::INT64}, {"bytes", ValueType::INT64}, {"latency", ValueType::DOUBLE},
+        {"cached", ValueType::BOOL}};
+
+    extractKV::ColumnarBatch batch(
+        {"ts", "status", "bytes", "latency", "cached"}, {}, extractKV::ColumnarBatch::DEFAULT_MAX_DICTIONARY_SIZE, types);
+
+    for (auto _ : state)
+    {
+        batch.clear();
+
+        for (const auto & row : rows())
+        {
+            extractor->extract(row, batch);
+        }
+
+        benchmark::DoNotOptimize(batch.getTypedColumn(0).data.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUMBER_OF_VALUES);
+}
+BENCHMARK(BM_TypedColumns);
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <KeyValuePairExtractorBuilder.h>
+
+/*
+ * Pre-flight validation of a large input compared with a full extraction of the same input.
+ * */
+namespace
+{
+    const std::string & input()
+    {
+        static const std::string data = []
+        {
+            std::string result;
+
+            for (size_t i = 0; i < 4096; ++i)
+            {
+                result += "key_" + std::to_string(i) + ":\"value " + std::to_string(i * 31) + "\" other_" + std::to_string(i) + ":plain ";
+            }
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    void escaping(benchmark::internal::Benchmark * benchmark)
+    {
+        benchmark->Arg(0)->Arg(1);
+    }
+
+    std::shared_ptr<KeyValuePairExtractor> makeExtractor(bool with_escaping)
+    {
+        auto builder = KeyValuePairExtractorBuilder();
+
+        if (with_escaping)
+        {
+            builder.withEscaping();
+        }
+
+        return builder.build();
+    }
+}
+
+static void BM_Validate(benchmark::State & state)
+{
+    const auto extractor = makeExtractor(state.range(0));
+
+    KeyValuePairExtractor::ValidationResult result;
+
+    for (auto _ : state)
+    {
+        extractor->validate(input(), result);
+        benchmark::DoNotOptimize(result.number_of_pairs);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_Validate)->Apply(escaping);
+
+static void BM_Extract(benchmark::State & state)
+{
+    const auto extractor = makeExtractor(state.range(0));
+
+    KeyValuePairExtractor::Response response;
+
+    for (auto _ : state)
+    {
+        extractor->extract(input(), response);
+        benchmark::DoNotOptimize(&response);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input().size()));
+}
+BENCHMARK(BM_Extract)->Apply(escaping);
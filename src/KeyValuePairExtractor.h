@@ -1,18 +1,137 @@
 #pragma once
 
+#include <expected>
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <impl/ColumnarBatch.h>
 #include <impl/Configuration.h>
+#include <impl/Diagnostics.h>
+#include <impl/ExtractionError.h>
+#include <impl/KeyDictionary.h>
+#include <impl/state/StateHandler.h>
 
 /*
-TODO    Update docs
+ * Extracts key value pairs from strings, see `KeyValuePairExtractorBuilder`.
+ *
+ * Extraction is const and keeps all of its state on the stack, so a single extractor can be shared by any number of threads without
+ * synchronization. Prefer sharing it by reference over copying the `std::shared_ptr` in hot loops, the reference count is a contended
+ * atomic.
  * */
 struct KeyValuePairExtractor {
     using Response = std::unordered_map<std::string, std::string>;
 
+    /*
+     * `Response` allocating from a `std::pmr::memory_resource`, e.g. a `std::pmr::monotonic_buffer_resource` per request.
+     * */
+    using PmrResponse = std::pmr::unordered_map<std::pmr::string, std::pmr::string>;
+    using ExtractionError = extractKV::ExtractionError;
+
+    /*
+     * Pairs whose keys are interned in the `extractKV::KeyDictionary` set with `KeyValuePairExtractorBuilder::withKeyDictionary`.
+     * Pairs are kept in input order, a duplicated key keeps its first position and its last value. Keys that no longer fit in the
+     * dictionary end up in `overflow`. Value strings of a row with fewer pairs than the previous one move to `spare_values`, so that
+     * later rows reuse their capacity.
+     * */
+    struct InternedResponse
+    {
+        std::vector<std::pair<extractKV::KeyDictionary::Id, std::string>> pairs;
+        Response overflow;
+        std::vector<std::string> spare_values;
+    };
+
+    /*
+     * Outcome of `validate`. `number_of_pairs` counts every flushed pair, duplicated keys included. Each malformed region spans the
+     * input consumed by the state that dropped it, as offsets into the row.
+     * */
+    struct ValidationResult
+    {
+        using Discard = extractKV::StateHandler::Discard;
+
+        struct MalformedRegion
+        {
+            size_t begin;
+            size_t end;
+            Discard reason;
+        };
+
+        uint64_t number_of_pairs = 0;
+        std::vector<MalformedRegion> malformed_regions;
+    };
+
     virtual ~KeyValuePairExtractor() = default;
 
-    virtual Response extract(const std::string & file) = 0;
+    /*
+     * Returns an empty map if the row was dropped by the filter.
+     * */
+    virtual Response extract(const std::string & file) const = 0;
+
+    /*
+     * Replaces the contents of `response` with the pairs found in `data`. The nodes, strings and bucket array of `response` are reused,
+     * so extracting rows of a similar shape into the same container doesn't allocate.
+     *
+     * Returns false if the row was dropped by the filter set with `KeyValuePairExtractorBuilder::withFilter`, `response` is left empty
+     * in that case. Extraction stops as soon as a predicate fails.
+     * */
+    virtual bool extract(std::string_view data, Response & response) const = 0;
+
+    /*
+     * Same as above, but keys, values and the buffers of the escaping state handler all allocate from the memory resource of
+     * `response`, so a whole extraction can run without touching the global heap.
+     * */
+    virtual bool extract(std::string_view data, PmrResponse & response) const = 0;
+
+    /*
+     * Same as `extract(data, response)`, recording every dropped token (e.g. a key running into a pair delimiter or an unterminated
+     * quote) into `diagnostics`, see `extractKV::Diagnostics`.
+     * */
+    virtual bool extract(std::string_view data, Response & response, extractKV::Diagnostics & diagnostics) const = 0;
+
+    /*
+     * Same as `extract(data, response)`, but errors like an exceeded limit are returned with their code and byte offset instead of
+     * thrown, which is much cheaper on dirty inputs that hit them often. `response` holds the pairs extracted before the error.
+     * */
+    virtual std::expected<bool, ExtractionError> tryExtract(std::string_view data, Response & response) const = 0;
+
+    /*
+     * Non throwing counterparts of the `PmrResponse` and `Diagnostics` overloads of `extract`.
+     * */
+    virtual std::expected<bool, ExtractionError> tryExtract(std::string_view data, PmrResponse & response) const = 0;
+
+    virtual std::expected<bool, ExtractionError> tryExtract(std::string_view data, Response & response,
+                                                            extractKV::Diagnostics & diagnostics) const = 0;
+
+    /*
+     * Same as `extract(data, response)`, but keys are interned. Requires a key dictionary, throws otherwise. Value strings of
+     * `response` are reused.
+     * */
+    virtual bool extract(std::string_view data, InternedResponse & response) const = 0;
+
+    /*
+     * Appends the pairs found in `data` as a row of `batch`, see `extractKV::ColumnarBatch`. Returns false if the row was dropped by
+     * the filter, nothing is appended in that case, nor if extraction fails.
+     * */
+    virtual bool extract(std::string_view data, extractKV::ColumnarBatch & batch) const = 0;
+
+    /*
+     * Same as above, returning errors instead of throwing them, see `tryExtract(data, response)`.
+     * */
+    virtual std::expected<bool, ExtractionError> tryExtract(std::string_view data, extractKV::ColumnarBatch & batch) const = 0;
+
+    /*
+     * Runs the same state transitions as `extract` without writing keys and values anywhere, and reports the number of pairs and the
+     * malformed regions of `data` into `result`. Meant as a cheap pre-flight check of input files. The row filter does not apply.
+     * */
+    virtual void validate(std::string_view data, ValidationResult & result) const = 0;
+
+    /*
+     * Value of `key` in `data`, same as looking `key` up in `extract(data)` (the last occurrence wins), but only the pairs around
+     * occurrences of `key` are parsed. Meant for queries like "the value of `request_id`" on long rows.
+     * */
+    virtual std::optional<std::string> extractValue(std::string_view data, std::string_view key) const = 0;
 
     virtual extractKV::Configuration getConfiguration() const = 0;
 };
\ No newline at end of file
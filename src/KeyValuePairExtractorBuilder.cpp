@@ -27,9 +27,46 @@ KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withEscaping()
     return *this;
 }
 
-KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withMaxNumberOfPairs(uint64_t max_number_of_pairs_)
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withMaxNumberOfPairs(uint64_t max_number_of_pairs_,
+                                                                                 extractKV::Limits::Policy policy)
 {
-    max_number_of_pairs = max_number_of_pairs_;
+    limits.number_of_pairs = {max_number_of_pairs_, policy};
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withMaxKeyLength(uint64_t max_key_length, extractKV::Limits::Policy policy)
+{
+    limits.key_length = {max_key_length, policy};
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withMaxValueLength(uint64_t max_value_length, extractKV::Limits::Policy policy)
+{
+    limits.value_length = {max_value_length, policy};
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withMaxOutputBytes(uint64_t max_output_bytes, extractKV::Limits::Policy policy)
+{
+    limits.output_bytes = {max_output_bytes, policy};
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withKeyDictionary(std::shared_ptr<extractKV::KeyDictionary> key_dictionary_)
+{
+    key_dictionary = std::move(key_dictionary_);
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withFilter(std::string_view expression)
+{
+    row_filter.add(expression);
+    return *this;
+}
+
+KeyValuePairExtractorBuilder & KeyValuePairExtractorBuilder::withLatencyHistogram(std::shared_ptr<extractKV::LatencyHistogram> latency_histogram_)
+{
+    latency_histogram = std::move(latency_histogram_);
     return *this;
 }
 
@@ -46,22 +83,51 @@ std::shared_ptr<KeyValuePairExtractor> KeyValuePairExtractorBuilder::build() con
 namespace
 {
     template <typename T>
-    auto makeStateHandler(const T && handler, uint64_t max_number_of_pairs)
+    auto makeStateHandler(const T && handler, extractKV::Limits limits, std::shared_ptr<extractKV::KeyDictionary> key_dictionary,
+                          std::shared_ptr<const extractKV::RowFilter> row_filter,
+                          std::shared_ptr<extractKV::LatencyHistogram> latency_histogram)
+    {
+        return std::make_shared<CHKeyValuePairExtractor<T>>(handler, limits, std::move(key_dictionary), std::move(row_filter),
+                                                            std::move(latency_histogram));
+    }
+}
+
+std::shared_ptr<const extractKV::RowFilter> KeyValuePairExtractorBuilder::buildRowFilter() const
+{
+    if (row_filter.empty())
     {
-        return std::make_shared<CHKeyValuePairExtractor<T>>(handler, max_number_of_pairs);
+        return nullptr;
     }
+
+    return std::make_shared<const extractKV::RowFilter>(row_filter);
 }
 
 std::shared_ptr<KeyValuePairExtractor> KeyValuePairExtractorBuilder::buildWithoutEscaping() const
 {
     auto configuration = extractKV::ConfigurationFactory::createWithoutEscaping(key_value_delimiter, quoting_character, item_delimiters);
 
-    return makeStateHandler(extractKV::NoEscapingStateHandler(configuration), max_number_of_pairs);
+    return makeStateHandler(extractKV::NoEscapingStateHandler(configuration), limits, key_dictionary, buildRowFilter(), latency_histogram);
 }
 
 std::shared_ptr<KeyValuePairExtractor> KeyValuePairExtractorBuilder::buildWithEscaping() const
 {
     auto configuration = extractKV::ConfigurationFactory::createWithEscaping(key_value_delimiter, quoting_character, item_delimiters);
 
-    return makeStateHandler(extractKV::InlineEscapingStateHandler(configuration), max_number_of_pairs);
+    return makeStateHandler(extractKV::InlineEscapingStateHandler(configuration), limits, key_dictionary, buildRowFilter(), latency_histogram);
+}
+
+NoEscapingExtractorHandle KeyValuePairExtractorBuilder::buildHandleWithoutEscaping() const
+{
+    auto configuration = extractKV::ConfigurationFactory::createWithoutEscaping(key_value_delimiter, quoting_character, item_delimiters);
+
+    return NoEscapingExtractorHandle(
+        CHKeyValuePairExtractor<extractKV::NoEscapingStateHandler>(extractKV::NoEscapingStateHandler(configuration), limits, key_dictionary, buildRowFilter(), latency_histogram));
+}
+
+InlineEscapingExtractorHandle KeyValuePairExtractorBuilder::buildHandleWithEscaping() const
+{
+    auto configuration = extractKV::ConfigurationFactory::createWithEscaping(key_value_delimiter, quoting_character, item_delimiters);
+
+    return InlineEscapingExtractorHandle(
+        CHKeyValuePairExtractor<extractKV::InlineEscapingStateHandler>(extractKV::InlineEscapingStateHandler(configuration), limits, key_dictionary, buildRowFilter(), latency_histogram));
 }
@@ -2,8 +2,11 @@
 
 #include <memory>
 #include <vector>
-#include <limits>
 #include <KeyValuePairExtractor.h>
+#include <KeyValuePairExtractorHandle.h>
+#include <impl/LatencyHistogram.h>
+#include <impl/Limits.h>
+#include <impl/RowFilter.h>
 
 class KeyValuePairExtractorBuilder
 {
@@ -17,18 +20,61 @@ public:
 
     KeyValuePairExtractorBuilder & withEscaping();
 
-    KeyValuePairExtractorBuilder & withMaxNumberOfPairs(uint64_t max_number_of_pairs_);
+    /*
+     * Per row limits, see `extractKV::Limits` for the policies. With the default `ERROR` policy, extraction methods throw once a limit
+     * is exceeded.
+     * */
+    KeyValuePairExtractorBuilder & withMaxNumberOfPairs(uint64_t max_number_of_pairs_,
+                                                        extractKV::Limits::Policy policy = extractKV::Limits::Policy::ERROR);
+
+    KeyValuePairExtractorBuilder & withMaxKeyLength(uint64_t max_key_length, extractKV::Limits::Policy policy = extractKV::Limits::Policy::ERROR);
+
+    KeyValuePairExtractorBuilder & withMaxValueLength(uint64_t max_value_length,
+                                                      extractKV::Limits::Policy policy = extractKV::Limits::Policy::ERROR);
+
+    KeyValuePairExtractorBuilder & withMaxOutputBytes(uint64_t max_output_bytes,
+                                                      extractKV::Limits::Policy policy = extractKV::Limits::Policy::ERROR);
+
+    /*
+     * Dictionary used by `KeyValuePairExtractor::extract(data, InternedResponse &)`. It can be shared by several extractors and threads.
+     * */
+    KeyValuePairExtractorBuilder & withKeyDictionary(std::shared_ptr<extractKV::KeyDictionary> key_dictionary_);
+
+    /*
+     * Adds a predicate rows must satisfy, e.g. `level=ERROR`, `status!=200`, `user` or `!user`. Rows failing any predicate are dropped,
+     * see `extractKV::RowFilter`.
+     * */
+    KeyValuePairExtractorBuilder & withFilter(std::string_view expression);
+
+    /*
+     * Records the latency of every `extract` call into `latency_histogram_`. It can be shared by several threads, use one per
+     * configuration to compare their tails.
+     * */
+    KeyValuePairExtractorBuilder & withLatencyHistogram(std::shared_ptr<extractKV::LatencyHistogram> latency_histogram_);
 
     std::shared_ptr<KeyValuePairExtractor> build() const;
 
+    /*
+     * Build concretely typed handles, see `KeyValuePairExtractorHandle`. Escaping support is part of the handle type,
+     * so `withEscaping()` only affects `build()`.
+     * */
+    NoEscapingExtractorHandle buildHandleWithoutEscaping() const;
+
+    InlineEscapingExtractorHandle buildHandleWithEscaping() const;
+
 private:
     bool with_escaping = false;
     char key_value_delimiter = ':';
     char quoting_character = '"';
     std::vector<char> item_delimiters = {' ', ',', ';'};
-    uint64_t max_number_of_pairs = std::numeric_limits<uint64_t>::max();
+    extractKV::Limits limits;
+    std::shared_ptr<extractKV::KeyDictionary> key_dictionary;
+    extractKV::RowFilter row_filter;
+    std::shared_ptr<extractKV::LatencyHistogram> latency_histogram;
 
     std::shared_ptr<KeyValuePairExtractor> buildWithEscaping() const;
 
     std::shared_ptr<KeyValuePairExtractor> buildWithoutEscaping() const;
+
+    std::shared_ptr<const extractKV::RowFilter> buildRowFilter() const;
 };
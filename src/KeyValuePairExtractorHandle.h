@@ -0,0 +1,73 @@
+#pragma once
+
+#include <expected>
+#include <functional>
+#include <string_view>
+#include <KeyValuePairExtractor.h>
+#include <impl/state/CHKeyValuePairExtractor.h>
+#include <impl/state/StateHandlerImpl.h>
+
+/*
+ * Concretely typed alternative to `KeyValuePairExtractor` for hot paths that extract from many tiny inputs.
+ *
+ * There is no virtual call and no `std::shared_ptr` involved, `extract` accepts `std::string_view` so callers holding `const char *`
+ * don't need a temporary `std::string`, and the output map is owned by the handle and reused across calls. The returned reference
+ * is valid until the next call to `extract`.
+ *
+ * Escaping support is part of the type, see `NoEscapingExtractorHandle` and `InlineEscapingExtractorHandle`. A handle is not thread
+ * safe, keep one per thread.
+ *
+ * The handle also remembers the key sequence of the previous input and checks it first, which pays off for rows of the same shape, see
+ * `extractKV::RowShape`.
+ * */
+template <typename StateHandler>
+class KeyValuePairExtractorHandle
+{
+public:
+    using Response = KeyValuePairExtractor::Response;
+    using ExtractionError = KeyValuePairExtractor::ExtractionError;
+
+    explicit KeyValuePairExtractorHandle(CHKeyValuePairExtractor<StateHandler> extractor_)
+        : extractor(std::move(extractor_))
+    {}
+
+    /*
+     * The response is empty if the row was dropped by the filter.
+     * */
+    const Response & extract(std::string_view data)
+    {
+        extractor.extract(data, response, row_shape);
+        return response;
+    }
+
+    /*
+     * Same as above, returning errors instead of throwing them, see `KeyValuePairExtractor::tryExtract`.
+     * */
+    std::expected<std::reference_wrapper<const Response>, ExtractionError> tryExtract(std::string_view data)
+    {
+        if (auto result = extractor.tryExtract(data, response, row_shape); !result)
+        {
+            return std::unexpected(result.error());
+        }
+
+        return std::cref(response);
+    }
+
+    const extractKV::RowShape & getRowShape() const
+    {
+        return row_shape;
+    }
+
+    extractKV::Configuration getConfiguration() const
+    {
+        return extractor.getConfiguration();
+    }
+
+private:
+    CHKeyValuePairExtractor<StateHandler> extractor;
+    Response response;
+    extractKV::RowShape row_shape;
+};
+
+using NoEscapingExtractorHandle = KeyValuePairExtractorHandle<extractKV::NoEscapingStateHandler>;
+using InlineEscapingExtractorHandle = KeyValuePairExtractorHandle<extractKV::InlineEscapingStateHandler>;
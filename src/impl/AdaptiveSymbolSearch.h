@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <util/find_symbols.h>
+#include <impl/ByteClassTable.h>
+
+namespace extractKV
+{
+    /*
+     * Searches for control characters either with `ByteClassTable` or with the SIMD `find_first_symbols` kernels, depending on a running
+     * average of the distance between control characters (i.e, token length) observed so far.
+     *
+     * On dense inputs like `a=1 b=2 c=3` every token is one or two bytes long and the setup of a SIMD search costs more than it saves,
+     * while on long values SIMD is several times faster. The scalar scan is capped at `SCALAR_SCAN_LIMIT` bytes and then hands the rest
+     * of the span over to SIMD, so a wrong guess never costs more than a few table lookups.
+     *
+     * Holds per extraction state, one instance must not be shared across threads.
+     * */
+    class AdaptiveSymbolSearch
+    {
+    public:
+        explicit AdaptiveSymbolSearch(const ByteClassTable & byte_classes_)
+            : byte_classes(byte_classes_)
+        {}
+
+        const char * findFirstSymbolOrNull(std::string_view haystack, const SearchSymbols & symbols, uint8_t classes)
+        {
+            return find<true>(haystack, symbols, classes);
+        }
+
+        const char * findFirstNotSymbolOrNull(std::string_view haystack, const SearchSymbols & symbols, uint8_t classes)
+        {
+            return find<false>(haystack, symbols, classes);
+        }
+
+    private:
+        // Tokens shorter than a SIMD register are better served by the table.
+        static constexpr int64_t SIMD_THRESHOLD = 16;
+        static constexpr size_t SCALAR_SCAN_LIMIT = 16;
+        // Exponential moving average with a weight of 1/8 for the newest observation, kept scaled by 8 to avoid losing precision.
+        static constexpr int64_t AVERAGE_SHIFT = 3;
+        // A single huge token should not keep the search in SIMD mode for the rest of the row.
+        static constexpr int64_t MAX_OBSERVED_TOKEN_LENGTH = 256;
+
+        const ByteClassTable & byte_classes;
+        int64_t scaled_average_token_length = 0;
+
+        template <bool positive>
+        const char * find(std::string_view haystack, const SearchSymbols & symbols, uint8_t classes)
+        {
+            const char * begin = haystack.begin();
+            const char * end = haystack.end();
+
+            const char * result = nullptr;
+
+            if (scaled_average_token_length < (SIMD_THRESHOLD << AVERAGE_SHIFT))
+            {
+                const char * scalar_end = begin + std::min(haystack.size(), SCALAR_SCAN_LIMIT);
+
+                result = byte_classes.findFirstOrNull<positive>(begin, scalar_end, classes);
+
+                if (!result && scalar_end != end)
+                {
+                    result = findSIMD<positive>({scalar_end, end}, symbols);
+                }
+            }
+            else
+            {
+                result = findSIMD<positive>(haystack, symbols);
+            }
+
+            observe(result ? result - begin : end - begin);
+
+            return result;
+        }
+
+        template <bool positive>
+        static const char * findSIMD(std::string_view haystack, const SearchSymbols & symbols)
+        {
+            if constexpr (positive)
+            {
+                return find_first_symbols_or_null(haystack, symbols);
+            }
+            else
+            {
+                return find_first_not_symbols_or_null(haystack, symbols);
+            }
+        }
+
+        void observe(int64_t token_length)
+        {
+            token_length = std::min(token_length, MAX_OBSERVED_TOKEN_LENGTH);
+            scaled_average_token_length += token_length - (scaled_average_token_length >> AVERAGE_SHIFT);
+        }
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <impl/Configuration.h>
+
+namespace extractKV
+{
+    /*
+     * Maps every byte to the control character classes it belongs to, based on the contents of `Configuration`. Classifying a byte
+     * is a single load, which makes the table cheaper than `find_first_symbols_or_null` on very short spans and replaces the
+     * comparisons against the pair delimiters list.
+     * */
+    class ByteClassTable
+    {
+    public:
+        enum Class : uint8_t
+        {
+            REGULAR = 0,
+            KEY_VALUE_DELIMITER = 1u << 0,
+            PAIR_DELIMITER = 1u << 1,
+            QUOTING_CHARACTER = 1u << 2,
+            ESCAPE_CHARACTER = 1u << 3,
+        };
+
+        ByteClassTable(const Configuration & configuration, bool with_escaping)
+        {
+            table[static_cast<uint8_t>(configuration.key_value_delimiter)] |= KEY_VALUE_DELIMITER;
+            table[static_cast<uint8_t>(configuration.quoting_character)] |= QUOTING_CHARACTER;
+
+            for (auto pair_delimiter : configuration.pair_delimiters)
+            {
+                table[static_cast<uint8_t>(pair_delimiter)] |= PAIR_DELIMITER;
+            }
+
+            if (with_escaping)
+            {
+                table['\\'] |= ESCAPE_CHARACTER;
+            }
+        }
+
+        bool is(char character, uint8_t classes) const
+        {
+            return table[static_cast<uint8_t>(character)] & classes;
+        }
+
+        /*
+         * Scalar counterpart of `find_first_symbols_or_null` (`positive`) and `find_first_not_symbols_or_null` (`!positive`).
+         * */
+        template <bool positive>
+        const char * findFirstOrNull(const char * begin, const char * end, uint8_t classes) const
+        {
+            for (; begin < end; ++begin)
+            {
+                if (is(*begin, classes) == positive)
+                {
+                    return begin;
+                }
+            }
+
+            return nullptr;
+        }
+
+    private:
+        std::array<uint8_t, 256> table {};
+    };
+}
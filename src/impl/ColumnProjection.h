@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <util/KeyHash.h>
+
+namespace extractKV
+{
+    /*
+     * Picks the values of a fixed list of columns out of a row, for the formats with one field per column (`CsvSerializer`,
+     * `TsvSerializer`, `ColumnarBatch`). The row is walked once and every key is looked up in a small hash table of the column names, by view, so the
+     * cost is independent of the number of columns and the same for any map type. Keys that are not columns are
+     * skipped and missing columns are empty.
+     *
+     * Rows of the same shape iterate their keys in the same order, so the n-th key is first compared with the n-th key of the previous
+     * row and only looked up on a mismatch.
+     * */
+    class ColumnProjection
+    {
+    public:
+        explicit ColumnProjection(std::vector<std::string> columns_)
+            : columns(std::move(columns_)),
+            slot_mask(std::bit_ceil(std::max<size_t>(16u, columns.size() * 2)) - 1),
+            slots(slot_mask + 1),
+            values(columns.size())
+        {
+            if (columns.empty())
+            {
+                throw std::runtime_error ("Invalid arguments, at least one column is required");
+            }
+
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                const auto hash = KeyHash::hash(columns[i]);
+                auto slot = hash & slot_mask;
+
+                while (slots[slot].column != EMPTY && columns[slots[slot].column] != columns[i])
+                {
+                    slot = (slot + 1) & slot_mask;
+                }
+
+                // The first occurrence of a repeated column name keeps the slot, the repetition stays empty
+                if (slots[slot].column == EMPTY)
+                {
+                    slots[slot] = {hash, i};
+                }
+            }
+        }
+
+        const std::vector<std::string> & getColumns() const
+        {
+            return columns;
+        }
+
+        /// Views into `row`, one per column in column order.
+        template <typename Map>
+        const std::vector<std::string_view> & project(const Map & row)
+        {
+            std::fill(values.begin(), values.end(), std::string_view());
+
+            size_t position = 0;
+
+            for (const auto & [key, value] : row)
+            {
+                if (const auto column = columnOf(key, position++); column != NOT_A_COLUMN)
+                {
+                    values[column] = value;
+                }
+            }
+
+            return values;
+        }
+
+        static constexpr size_t NOT_A_COLUMN = std::numeric_limits<size_t>::max();
+
+        /// Column of `key`, the `position`-th key of its row, or `NOT_A_COLUMN`.
+        size_t columnOf(std::string_view key, size_t position)
+        {
+            return columnOf(key, position, [key] { return KeyHash::hash(key); });
+        }
+
+        /// Same as above, `key_hash` must be `KeyHash::hash(key)`.
+        size_t columnOf(std::string_view key, uint64_t key_hash, size_t position)
+        {
+            return columnOf(key, position, [key_hash] { return key_hash; });
+        }
+
+    private:
+        static constexpr size_t EMPTY = NOT_A_COLUMN;
+
+        size_t columnOf(std::string_view key, size_t position, auto hash)
+        {
+            if (position == previous_keys.size())
+            {
+                previous_keys.emplace_back();
+            }
+
+            auto & [previous_key, column] = previous_keys[position];
+
+            if (previous_key != key)
+            {
+                previous_key.assign(key);
+                column = find(key, hash());
+            }
+
+            return column;
+        }
+
+        /// Open addressing with linear probing at a load factor of at most 0.5, like `KeyDictionary`.
+        struct Slot
+        {
+            uint64_t hash = 0;
+            size_t column = EMPTY;
+        };
+
+        size_t find(std::string_view key, uint64_t hash) const
+        {
+            for (auto slot = hash & slot_mask;; slot = (slot + 1) & slot_mask)
+            {
+                const auto & [slot_hash, column] = slots[slot];
+
+                if (column == EMPTY || (slot_hash == hash && columns[column] == key))
+                {
+                    return column;
+                }
+            }
+        }
+
+        std::vector<std::string> columns;
+
+        const size_t slot_mask;
+        std::vector<Slot> slots;
+
+        std::vector<std::string_view> values;
+
+        /// Keys of the previous row in iteration order with their columns, rows of the same shape skip the hash table lookups.
+        std::vector<std::pair<std::string, size_t>> previous_keys;
+    };
+}
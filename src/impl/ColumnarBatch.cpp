@@ -0,0 +1,644 @@
+#include <impl/ColumnarBatch.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace extractKV
+{
+    namespace
+    {
+        using Encoding = ColumnarBatch::Encoding;
+        using DictionaryColumn = ColumnarBatch::DictionaryColumn;
+
+        void closeValue(Utf8Column & column)
+        {
+            if (column.data.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) [[unlikely]]
+            {
+                throw std::runtime_error ("Column data exceeds 2 GiB, the batch must be flushed earlier");
+            }
+
+            column.offsets.push_back(static_cast<int32_t>(column.data.size()));
+        }
+
+        void appendValue(Utf8Column & column, std::string_view value)
+        {
+            column.data.append(value);
+            closeValue(column);
+        }
+
+        void appendValidity(std::vector<uint8_t> & validity, size_t & null_count, size_t index, bool valid)
+        {
+            if (index % 8 == 0)
+            {
+                validity.push_back(0);
+            }
+
+            if (valid)
+            {
+                validity.back() |= static_cast<uint8_t>(1u << (index % 8));
+            }
+            else
+            {
+                ++null_count;
+            }
+        }
+
+        void appendValidity(Utf8Column & column, bool valid)
+        {
+            appendValidity(column.validity, column.null_count, column.size() - 1u, valid);
+        }
+
+        /// Drops the values after the first `size`.
+        void truncate(Utf8Column & column, size_t size)
+        {
+            column.offsets.resize(size + 1u);
+            column.data.resize(column.offsets.back());
+        }
+
+        void clearColumn(Utf8Column & column)
+        {
+            truncate(column, 0);
+            column.validity.clear();
+            column.null_count = 0;
+        }
+
+        /// Number of distinct values an encoding can index.
+        size_t indexCapacity(Encoding encoding)
+        {
+            return encoding == Encoding::DICTIONARY_UINT8 ? 256u : 65536u;
+        }
+
+        uint32_t indexAt(const DictionaryColumn & column, Encoding encoding, size_t row)
+        {
+            if (encoding == Encoding::DICTIONARY_UINT8)
+            {
+                return column.indices[row];
+            }
+
+            return column.indices[row * 2] | (static_cast<uint32_t>(column.indices[row * 2 + 1]) << 8);
+        }
+
+        void appendIndex(DictionaryColumn & column, Encoding encoding, uint32_t index)
+        {
+            column.indices.push_back(static_cast<uint8_t>(index));
+
+            if (encoding == Encoding::DICTIONARY_UINT16)
+            {
+                column.indices.push_back(static_cast<uint8_t>(index >> 8));
+            }
+        }
+
+        size_t validateMaxDictionarySize(size_t max_dictionary_size)
+        {
+            if (max_dictionary_size == 0 || max_dictionary_size > 65536u)
+            {
+                throw std::runtime_error ("Invalid arguments, max dictionary size must be between 1 and 65536");
+            }
+
+            return max_dictionary_size;
+        }
+    }
+
+    ColumnarBatch::ColumnarBatch() = default;
+
+    ColumnarBatch::ColumnarBatch(std::vector<std::string> columns_, const std::vector<std::string> & low_cardinality_columns,
+                                 size_t max_dictionary_size_, const std::vector<std::pair<std::string, ValueType>> & column_types)
+        : projection(std::in_place, std::move(columns_)),
+        encodings(projection->getColumns().size(), Encoding::PLAIN),
+        columns(projection->getColumns().size()),
+        dictionary_columns(projection->getColumns().size()),
+        types(projection->getColumns().size(), ValueType::STRING),
+        typed_columns(projection->getColumns().size()),
+        max_dictionary_size(validateMaxDictionarySize(max_dictionary_size_)),
+        row_has_value(projection->getColumns().size()),
+        row_dictionary_values(projection->getColumns().size()),
+        row_typed_values(projection->getColumns().size()),
+        row_value_invalid(projection->getColumns().size())
+    {
+        const auto & names = projection->getColumns();
+
+        auto index_of = [&](const std::string & name, std::string_view kind)
+        {
+            const auto it = std::find(names.begin(), names.end(), name);
+
+            if (it == names.end())
+            {
+                throw std::runtime_error ("Invalid arguments, " + std::string(kind) + " column '" + name + "' is not one of the columns");
+            }
+
+            return static_cast<size_t>(it - names.begin());
+        };
+
+        for (const auto & name : low_cardinality_columns)
+        {
+            const auto column_index = index_of(name, "low cardinality");
+
+            encodings[column_index] = Encoding::DICTIONARY_UINT8;
+            dictionary_columns[column_index].emplace();
+        }
+
+        for (const auto & [name, type] : column_types)
+        {
+            const auto column_index = index_of(name, "typed");
+
+            if (type == ValueType::STRING)
+            {
+                continue;
+            }
+
+            if (dictionary_columns[column_index])
+            {
+                throw std::runtime_error ("Invalid arguments, column '" + name + "' can't be both low cardinality and typed");
+            }
+
+            types[column_index] = type;
+            typed_columns[column_index].emplace().type = type;
+        }
+    }
+
+    size_t ColumnarBatch::dataSize() const
+    {
+        size_t size = keys.data.size() + values.data.size();
+
+        for (const auto & column : columns)
+        {
+            size += column.data.size();
+        }
+
+        for (const auto & column : dictionary_columns)
+        {
+            if (column)
+            {
+                size += column->dictionary.getValues().data.size() + column->indices.size();
+            }
+        }
+
+        for (const auto & column : typed_columns)
+        {
+            if (column)
+            {
+                size += column->data.size();
+            }
+        }
+
+        return size;
+    }
+
+    bool ColumnarBatch::isFull() const
+    {
+        // The first batch adapts the encodings instead
+        if (!encodings_frozen)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < encodings.size(); ++i)
+        {
+            if (encodings[i] != Encoding::PLAIN && dictionary_columns[i]->dictionary.size() >= indexCapacity(encodings[i]))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const std::vector<std::string> & ColumnarBatch::getColumnNames() const
+    {
+        return projection.value().getColumns();
+    }
+
+    ColumnarBatch::Encoding ColumnarBatch::getEncoding(size_t index) const
+    {
+        return isMap() ? Encoding::PLAIN : encodings.at(index);
+    }
+
+    ValueType ColumnarBatch::getType(size_t index) const
+    {
+        return isMap() ? ValueType::STRING : types.at(index);
+    }
+
+    const Utf8Column & ColumnarBatch::getColumn(size_t index) const
+    {
+        if (getEncoding(index) != Encoding::PLAIN || getType(index) != ValueType::STRING)
+        {
+            throw std::runtime_error ("Column '" + getColumnNames()[index] + "' is not a plain string column");
+        }
+
+        return columns.at(index);
+    }
+
+    const TypedColumn & ColumnarBatch::getTypedColumn(size_t index) const
+    {
+        if (getType(index) == ValueType::STRING)
+        {
+            throw std::runtime_error ("Column '" + getColumnNames()[index] + "' is a string column");
+        }
+
+        return *typed_columns[index];
+    }
+
+    const DictionaryColumn & ColumnarBatch::getDictionaryColumn(size_t index) const
+    {
+        if (getEncoding(index) == Encoding::PLAIN)
+        {
+            throw std::runtime_error ("Column '" + getColumnNames()[index] + "' is not dictionary encoded");
+        }
+
+        return *dictionary_columns[index];
+    }
+
+    void ColumnarBatch::clear()
+    {
+        map_offsets.resize(1);
+        clearColumn(keys);
+        clearColumn(values);
+
+        for (auto & column : columns)
+        {
+            clearColumn(column);
+        }
+
+        for (auto & column : dictionary_columns)
+        {
+            if (column)
+            {
+                column->dictionary.clear();
+                column->indices.clear();
+                column->validity.clear();
+                column->null_count = 0;
+            }
+        }
+
+        for (auto & column : typed_columns)
+        {
+            if (column)
+            {
+                column->data.clear();
+                column->validity.clear();
+                column->null_count = 0;
+                column->invalid.clear();
+                column->invalid_count = 0;
+                column->rows = 0;
+            }
+        }
+
+        discardRow();
+        number_of_rows = 0;
+
+        // The schema of the stream is fixed by the first batch
+        encodings_frozen = true;
+    }
+
+    void ColumnarBatch::addPair(std::string_view key, uint64_t key_hash, std::string_view value)
+    {
+        if (!projection)
+        {
+            addMapEntry(key, key_hash, value);
+            return;
+        }
+
+        const auto column_index = projection->columnOf(key, key_hash, row_position++);
+
+        if (column_index == ColumnProjection::NOT_A_COLUMN)
+        {
+            return;
+        }
+
+        if (types[column_index] != ValueType::STRING)
+        {
+            parseTypedValue(column_index, value);
+        }
+        else if (encodings[column_index] == Encoding::PLAIN)
+        {
+            // The current value is at the end of the column, overwritten if the key repeats
+            auto & column = columns[column_index];
+            column.data.resize(column.offsets.back());
+            column.data.append(value);
+        }
+        else
+        {
+            row_dictionary_values[column_index].assign(value);
+        }
+
+        row_has_value[column_index] = true;
+    }
+
+    void ColumnarBatch::addMapEntry(std::string_view key, uint64_t key_hash, std::string_view value)
+    {
+        // Cheap filter for duplicated keys: only scan the row if a hash with the same low bits was already seen, see `InterningSink`
+        const uint64_t hash_bit = 1ull << (key_hash & 63u);
+
+        if (row_key_hash_bits & hash_bit)
+        {
+            const size_t row_begin = map_offsets.back();
+
+            for (size_t i = 0; i < row_key_hashes.size(); ++i)
+            {
+                if (row_key_hashes[i] == key_hash && keys.value(row_begin + i) == key)
+                {
+                    eraseMapEntry(row_begin + i);
+                    row_key_hashes.erase(row_key_hashes.begin() + static_cast<ptrdiff_t>(i));
+                    break;
+                }
+            }
+        }
+
+        row_key_hash_bits |= hash_bit;
+        row_key_hashes.push_back(key_hash);
+
+        appendValue(keys, key);
+        appendValue(values, value);
+    }
+
+    void ColumnarBatch::eraseMapEntry(size_t entry)
+    {
+        for (auto * column : {&keys, &values})
+        {
+            const auto begin = column->offsets[entry];
+            const auto length = column->offsets[entry + 1] - begin;
+
+            column->data.erase(begin, length);
+            column->offsets.erase(column->offsets.begin() + static_cast<ptrdiff_t>(entry) + 1);
+
+            for (size_t i = entry + 1; i < column->offsets.size(); ++i)
+            {
+                column->offsets[i] -= length;
+            }
+        }
+    }
+
+    void ColumnarBatch::commitRow()
+    {
+        if (!projection)
+        {
+            map_offsets.push_back(static_cast<int32_t>(keys.size()));
+        }
+        else
+        {
+            try
+            {
+                checkRowFits();
+            }
+            catch (...)
+            {
+                discardRow();
+                throw;
+            }
+        }
+
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (types[i] != ValueType::STRING)
+            {
+                commitTypedValue(i);
+                continue;
+            }
+
+            uint32_t row_dictionary_index = 0;
+
+            if (encodings[i] != Encoding::PLAIN)
+            {
+                if (row_has_value[i])
+                {
+                    row_dictionary_index = dictionary_columns[i]->dictionary.insert(row_dictionary_values[i]);
+                }
+
+                adaptEncoding(i);
+            }
+
+            if (encodings[i] == Encoding::PLAIN)
+            {
+                closeValue(columns[i]);
+                appendValidity(columns[i], row_has_value[i]);
+            }
+            else
+            {
+                commitDictionaryValue(i, row_dictionary_index);
+            }
+        }
+
+        ++number_of_rows;
+
+        row_key_hashes.clear();
+        row_key_hash_bits = 0;
+        std::fill(row_has_value.begin(), row_has_value.end(), false);
+        row_position = 0;
+    }
+
+    void ColumnarBatch::discardRow()
+    {
+        truncate(keys, map_offsets.back());
+        truncate(values, map_offsets.back());
+
+        for (auto & column : columns)
+        {
+            column.data.resize(column.offsets.back());
+        }
+
+        row_key_hashes.clear();
+        row_key_hash_bits = 0;
+        std::fill(row_has_value.begin(), row_has_value.end(), false);
+        row_position = 0;
+    }
+
+    void ColumnarBatch::checkRowFits() const
+    {
+        constexpr auto max_data_size = static_cast<size_t>(std::numeric_limits<int32_t>::max());
+
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (types[i] != ValueType::STRING)
+            {
+                continue;
+            }
+
+            if (encodings[i] == Encoding::PLAIN)
+            {
+                if (columns[i].data.size() > max_data_size) [[unlikely]]
+                {
+                    throw std::runtime_error ("Column data exceeds 2 GiB, the batch must be flushed earlier");
+                }
+
+                continue;
+            }
+
+            if (!row_has_value[i])
+            {
+                continue;
+            }
+
+            const auto & dictionary = dictionary_columns[i]->dictionary;
+            const auto & value = row_dictionary_values[i];
+
+            // Before the encodings are frozen a full dictionary widens or falls back to plain strings instead
+            const bool out_of_indices = encodings_frozen && dictionary.size() >= indexCapacity(encodings[i]);
+            const bool out_of_data = dictionary.getValues().data.size() + value.size() > max_data_size;
+
+            // Only a new value needs room, the lookup is skipped while there is room anyway
+            if ((!out_of_indices && !out_of_data) || dictionary.contains(value))
+            {
+                continue;
+            }
+
+            if (out_of_data) [[unlikely]]
+            {
+                throw std::runtime_error ("Dictionary data exceeds 2 GiB, the batch must be flushed earlier");
+            }
+
+            throw std::runtime_error ("Dictionary of column '" + getColumnNames()[i]
+                                      + "' is full, the batch must be written before adding rows");
+        }
+    }
+
+    void ColumnarBatch::adaptEncoding(size_t column_index)
+    {
+        auto & encoding = encodings[column_index];
+        auto & column = *dictionary_columns[column_index];
+        const auto dictionary_size = column.dictionary.size();
+
+        if (encodings_frozen)
+        {
+            return;
+        }
+
+        if (dictionary_size <= std::min(indexCapacity(encoding), max_dictionary_size))
+        {
+            return;
+        }
+
+        if (dictionary_size <= max_dictionary_size)
+        {
+            // Widen the indices of the rows so far
+            std::vector<uint8_t> indices;
+            indices.reserve(column.indices.capacity() * 2);
+
+            for (const auto index : column.indices)
+            {
+                indices.push_back(index);
+                indices.push_back(0);
+            }
+
+            column.indices.swap(indices);
+            encoding = Encoding::DICTIONARY_UINT16;
+            return;
+        }
+
+        // Too many distinct values, fall back to plain strings, including the value of the current row
+        auto & plain = columns[column_index];
+        const auto & values = column.dictionary.getValues();
+
+        for (size_t row = 0; row < number_of_rows; ++row)
+        {
+            const auto valid = column.validity[row / 8] & (1u << (row % 8));
+
+            if (valid)
+            {
+                plain.data.append(values.value(indexAt(column, encoding, row)));
+            }
+
+            closeValue(plain);
+            appendValidity(plain, valid);
+        }
+
+        if (row_has_value[column_index])
+        {
+            plain.data.append(row_dictionary_values[column_index]);
+        }
+
+        encoding = Encoding::PLAIN;
+        dictionary_columns[column_index].reset();
+    }
+
+    void ColumnarBatch::commitDictionaryValue(size_t column_index, uint32_t index)
+    {
+        auto & column = *dictionary_columns[column_index];
+        const auto valid = row_has_value[column_index] != 0;
+
+        appendIndex(column, encodings[column_index], valid ? index : 0);
+        appendValidity(column.validity, column.null_count, number_of_rows, valid);
+    }
+
+    void ColumnarBatch::parseTypedValue(size_t column_index, std::string_view value)
+    {
+        auto & bits = row_typed_values[column_index];
+        bool valid = false;
+
+        switch (types[column_index])
+        {
+            case ValueType::INT64:
+            {
+                int64_t parsed = 0;
+                valid = parseInt64(value, parsed);
+                bits = static_cast<uint64_t>(parsed);
+                break;
+            }
+            case ValueType::DOUBLE:
+            {
+                double parsed = 0;
+                valid = parseDouble(value, parsed);
+                bits = std::bit_cast<uint64_t>(parsed);
+                break;
+            }
+            case ValueType::BOOL:
+            {
+                bool parsed = false;
+                valid = parseBool(value, parsed);
+                bits = parsed;
+                break;
+            }
+            case ValueType::TIMESTAMP:
+            {
+                int64_t parsed = 0;
+                valid = parseTimestamp(value, parsed);
+                bits = static_cast<uint64_t>(parsed);
+                break;
+            }
+            case ValueType::STRING:
+                break;
+        }
+
+        row_value_invalid[column_index] = !valid;
+    }
+
+    void ColumnarBatch::commitTypedValue(size_t column_index)
+    {
+        auto & column = *typed_columns[column_index];
+        const auto row = column.rows++;
+        const bool present = row_has_value[column_index] != 0;
+        const bool valid = present && !row_value_invalid[column_index];
+        const uint64_t bits = valid ? row_typed_values[column_index] : 0;
+
+        if (column.type == ValueType::BOOL)
+        {
+            if (row % 8 == 0)
+            {
+                column.data.push_back(0);
+            }
+
+            column.data.back() |= static_cast<uint8_t>(bits << (row % 8));
+        }
+        else
+        {
+            const auto size = column.data.size();
+            column.data.resize(size + sizeof(bits));
+            memcpy(column.data.data() + size, &bits, sizeof(bits));
+        }
+
+        appendValidity(column.validity, column.null_count, row, valid);
+
+        if (row % 8 == 0)
+        {
+            column.invalid.push_back(0);
+        }
+
+        if (present && !valid)
+        {
+            column.invalid.back() |= static_cast<uint8_t>(1u << (row % 8));
+            ++column.invalid_count;
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <impl/ColumnProjection.h>
+#include <impl/TypedColumn.h>
+#include <impl/Utf8Column.h>
+#include <impl/ValueDictionary.h>
+
+namespace extractKV
+{
+    /*
+     * Extracted rows in Arrow's columnar layout, filled one row at a time by `KeyValuePairExtractor::extract(data, batch)` and written
+     * out by `ArrowStreamWriter`. Pairs are appended straight to the offset and data buffers of the columns, without a map per row.
+     *
+     * There are two layouts:
+     * - map (default constructor): a single `Map<Utf8, Utf8>` column holding all pairs of each row in input order. A duplicated key
+     *   keeps its last value, like `Response`, and moves to the position of its last occurrence.
+     * - projected (`ColumnarBatch(columns)`): one nullable `Utf8` column per requested key, null for rows without that key. Other keys
+     *   are skipped, see `ColumnProjection`.
+     *
+     * Offsets are 32 bit like Arrow's `Utf8`, so a column holds at most 2 GiB of data, flush the batch well before that (`dataSize()`).
+     * `clear()` keeps the capacity of all buffers for the next batch.
+     *
+     * Low cardinality columns of the projected layout, e.g. `level` or `method`, are dictionary encoded like ClickHouse's
+     * `LowCardinality`: each distinct value is stored once in a `ValueDictionary` and rows hold its index, a `uint8_t` while there are
+     * at most 256 distinct values and a `uint16_t` beyond. A column whose dictionary grows past `max_dictionary_size` falls back to
+     * plain strings. The encoding adapts during the first batch only and is kept by `clear()`, because the schema of an Arrow stream
+     * can't change: if a later batch runs out of indices, `isFull()` asks for the batch to be written before the next row. Each batch
+     * has its own dictionary, values are only added to it when their row is committed, at most one per column and row.
+     *
+     * `commitRow()` checks that the row fits into every column before appending to any of them, a row that doesn't fit is
+     * discarded and leaves the batch as it was.
+     *
+     * Columns of the projected layout with a declared `ValueType` are parsed while the row is extracted, into a `TypedColumn`, so that
+     * consumers get numbers instead of re-parsing strings. Values that don't parse are null and counted as invalid.
+     * */
+    class ColumnarBatch
+    {
+    public:
+        using Utf8Column = extractKV::Utf8Column;
+
+        /// Same as ClickHouse's `low_cardinality_max_dictionary_size`.
+        static constexpr size_t DEFAULT_MAX_DICTIONARY_SIZE = 8192;
+
+        enum class Encoding
+        {
+            PLAIN,
+            DICTIONARY_UINT8,
+            DICTIONARY_UINT16,
+        };
+
+        /// Index of each row's value in `dictionary`, as little endian `uint8_t` or `uint16_t`, zero for nulls.
+        struct DictionaryColumn
+        {
+            ValueDictionary dictionary;
+            std::vector<uint8_t> indices;
+
+            /// Same as `Utf8Column::validity`.
+            std::vector<uint8_t> validity;
+            size_t null_count = 0;
+        };
+
+        ColumnarBatch();
+
+        explicit ColumnarBatch(std::vector<std::string> columns, const std::vector<std::string> & low_cardinality_columns = {},
+                               size_t max_dictionary_size_ = DEFAULT_MAX_DICTIONARY_SIZE,
+                               const std::vector<std::pair<std::string, ValueType>> & column_types = {});
+
+        bool isMap() const
+        {
+            return !projection.has_value();
+        }
+
+        size_t numberOfRows() const
+        {
+            return number_of_rows;
+        }
+
+        /// Bytes of keys, values, indices and typed values in the batch.
+        size_t dataSize() const;
+
+        /// Whether a dictionary ran out of indices, the batch must be written and cleared before the next row is added.
+        bool isFull() const;
+
+        /// Projected layout only.
+        const std::vector<std::string> & getColumnNames() const;
+
+        Encoding getEncoding(size_t index) const;
+
+        ValueType getType(size_t index) const;
+
+        /// `STRING` column with `PLAIN` encoding.
+        const Utf8Column & getColumn(size_t index) const;
+
+        /// Column of any other type.
+        const TypedColumn & getTypedColumn(size_t index) const;
+
+        /// Column with a dictionary encoding.
+        const DictionaryColumn & getDictionaryColumn(size_t index) const;
+
+        /// Map layout only, the entries of row `i` are `[map_offsets[i], map_offsets[i + 1])` of `getKeys()` and `getValues()`.
+        const std::vector<int32_t> & getMapOffsets() const
+        {
+            return map_offsets;
+        }
+
+        const Utf8Column & getKeys() const
+        {
+            return keys;
+        }
+
+        const Utf8Column & getValues() const
+        {
+            return values;
+        }
+
+        void clear();
+
+        /// Adds a pair to the current row, which is appended by `commitRow()` or dropped by `discardRow()`. See `ColumnarSink`.
+        void addPair(std::string_view key, uint64_t key_hash, std::string_view value);
+
+        void commitRow();
+
+        void discardRow();
+
+    private:
+        void addMapEntry(std::string_view key, uint64_t key_hash, std::string_view value);
+
+        void eraseMapEntry(size_t entry);
+
+        /// Throws if the current row doesn't fit into its columns, before any of them is changed.
+        void checkRowFits() const;
+
+        /// Adapts the encoding of a dictionary column to the size of its dictionary, before the current row is committed.
+        void adaptEncoding(size_t column_index);
+
+        void commitDictionaryValue(size_t column_index, uint32_t index);
+
+        void parseTypedValue(size_t column_index, std::string_view value);
+
+        void commitTypedValue(size_t column_index);
+
+        // Map layout
+        std::vector<int32_t> map_offsets {0};
+        Utf8Column keys;
+        Utf8Column values;
+
+        /// Key hashes of the entries of the current row, to find duplicated keys.
+        std::vector<uint64_t> row_key_hashes;
+        uint64_t row_key_hash_bits = 0;
+
+        // Projected layout
+        std::optional<ColumnProjection> projection;
+        std::vector<Encoding> encodings;
+        std::vector<Utf8Column> columns;
+        std::vector<std::optional<DictionaryColumn>> dictionary_columns;
+        std::vector<ValueType> types;
+        std::vector<std::optional<TypedColumn>> typed_columns;
+
+        size_t max_dictionary_size = DEFAULT_MAX_DICTIONARY_SIZE;
+        bool encodings_frozen = false;
+
+        /// Whether the current row has a value for each column, and its value for dictionary encoded columns, overwritten if the key
+        /// repeats and added to the dictionary by `commitRow()`.
+        std::vector<uint8_t> row_has_value;
+        std::vector<std::string> row_dictionary_values;
+
+        /// Parsed value of the current row for typed columns, the bits of an `int64_t`, `double` or `bool`, unless it is invalid.
+        std::vector<uint64_t> row_typed_values;
+        std::vector<uint8_t> row_value_invalid;
+
+        size_t number_of_rows = 0;
+        size_t row_position = 0;
+    };
+}
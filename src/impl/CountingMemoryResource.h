@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace extractKV
+{
+    /*
+     * `std::pmr::memory_resource` that forwards to `upstream` and counts allocations, bytes allocated and the peak of live bytes. Pass it
+     * to a `KeyValuePairExtractor::PmrResponse` to measure what an extraction allocates: the response and the escaping writers both
+     * allocate from it.
+     *
+     * Counters are plain integers, keep one instance per thread.
+     * */
+    class CountingMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        struct Stats
+        {
+            uint64_t allocations = 0;
+            uint64_t deallocations = 0;
+            uint64_t bytes_allocated = 0;
+            uint64_t live_bytes = 0;
+            uint64_t peak_live_bytes = 0;
+        };
+
+        explicit CountingMemoryResource(std::pmr::memory_resource * upstream_ = std::pmr::get_default_resource())
+            : upstream(upstream_)
+        {}
+
+        const Stats & getStats() const
+        {
+            return stats;
+        }
+
+        /// Starts a new measurement, e.g. per `extract` call. Bytes still live are kept, so that the peak stays meaningful.
+        void resetStats()
+        {
+            stats = {.live_bytes = stats.live_bytes, .peak_live_bytes = stats.live_bytes};
+        }
+
+    private:
+        void * do_allocate(size_t bytes, size_t alignment) override
+        {
+            void * pointer = upstream->allocate(bytes, alignment);
+
+            ++stats.allocations;
+            stats.bytes_allocated += bytes;
+            stats.live_bytes += bytes;
+            stats.peak_live_bytes = std::max(stats.peak_live_bytes, stats.live_bytes);
+
+            return pointer;
+        }
+
+        void do_deallocate(void * pointer, size_t bytes, size_t alignment) override
+        {
+            upstream->deallocate(pointer, bytes, alignment);
+
+            ++stats.deallocations;
+            stats.live_bytes -= bytes;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource * upstream;
+        Stats stats;
+    };
+}
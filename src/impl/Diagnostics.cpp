@@ -0,0 +1,99 @@
+#include <impl/Diagnostics.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace extractKV
+{
+    Diagnostics::Diagnostics(size_t event_capacity_, size_t sample_capacity_, uint64_t seed)
+        : event_capacity(event_capacity_), sample_capacity(sample_capacity_), random_state(seed)
+    {
+        if (event_capacity == 0)
+        {
+            throw std::runtime_error ("Invalid arguments, diagnostics need room for at least one event");
+        }
+
+        ring.reserve(event_capacity);
+        reservoir.reserve(sample_capacity);
+    }
+
+    void Diagnostics::beginRow()
+    {
+        ++number_of_rows;
+    }
+
+    void Diagnostics::record(Discard reason, size_t begin, size_t end, std::string_view row_data)
+    {
+        const Event event {reason, number_of_rows ? number_of_rows - 1 : 0, begin, end};
+
+        if (ring.size() < event_capacity)
+        {
+            ring.push_back(event);
+        }
+        else
+        {
+            ring[number_of_events % ring.size()] = event;
+        }
+
+        ++counts[static_cast<size_t>(reason)];
+
+        // Algorithm R: the n-th event replaces a random sample with probability `sample_capacity / n`.
+        Sample * sample = nullptr;
+
+        if (number_of_samples < sample_capacity)
+        {
+            if (number_of_samples == reservoir.size())
+            {
+                reservoir.emplace_back();
+            }
+
+            sample = &reservoir[number_of_samples++];
+        }
+        else if (const auto slot = nextRandom() % (number_of_events + 1); slot < sample_capacity)
+        {
+            sample = &reservoir[slot];
+        }
+
+        if (sample)
+        {
+            const auto snippet_begin = std::min(begin, row_data.size());
+            sample->event = event;
+            sample->snippet.assign(row_data.substr(snippet_begin, std::min(end - snippet_begin, MAX_SNIPPET_LENGTH)));
+        }
+
+        ++number_of_events;
+    }
+
+    std::vector<Diagnostics::Event> Diagnostics::events() const
+    {
+        std::vector<Event> result;
+        result.reserve(ring.size());
+
+        const auto oldest = ring.size() < event_capacity ? 0 : number_of_events % ring.size();
+
+        for (size_t i = 0; i < ring.size(); ++i)
+        {
+            result.push_back(ring[(oldest + i) % ring.size()]);
+        }
+
+        return result;
+    }
+
+    void Diagnostics::clear()
+    {
+        ring.clear();
+        number_of_samples = 0;
+        counts = {};
+        number_of_events = 0;
+        number_of_rows = 0;
+    }
+
+    uint64_t Diagnostics::nextRandom()
+    {
+        // splitmix64
+        auto z = (random_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
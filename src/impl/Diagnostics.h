@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <impl/state/StateHandler.h>
+
+namespace extractKV
+{
+    /*
+     * Records the tokens dropped while extracting, to explain data loss without a second debugging pass over the input.
+     *
+     * Memory is bounded: the last `event_capacity` events (reason, row, byte range) are kept in a ring buffer, counters per reason cover
+     * all of them, and `sample_capacity` events keep a snippet of the input (at most `MAX_SNIPPET_LENGTH` bytes). Snippets are a uniform
+     * sample over all events (reservoir sampling), so rare reasons show up in proportion to how often they happen, not only when they
+     * happen last. Snippet strings are reused, also after `clear()`, a warmed up instance doesn't allocate.
+     *
+     * Extraction only pays for diagnostics when an instance is passed, see `KeyValuePairExtractor::extract`. A `Diagnostics` is mutable
+     * state: keep one per thread and merge the reports, or pass it to one extractor only.
+     * */
+    class Diagnostics
+    {
+    public:
+        using Discard = StateHandler::Discard;
+
+        static constexpr size_t MAX_SNIPPET_LENGTH = 64;
+
+        struct Event
+        {
+            Discard reason;
+            // Zero based index of the row, counted by `beginRow`.
+            uint64_t row;
+            size_t begin;
+            size_t end;
+        };
+
+        struct Sample
+        {
+            Event event;
+            // The input of the event, cut at `MAX_SNIPPET_LENGTH` bytes.
+            std::string snippet;
+        };
+
+        explicit Diagnostics(size_t event_capacity_ = 1024, size_t sample_capacity_ = 16, uint64_t seed = 0x9E3779B97F4A7C15ull);
+
+        /// Starts the next row, events are attributed to it.
+        void beginRow();
+
+        /// Records that the bytes [begin, end) of `row_data` were dropped.
+        void record(Discard reason, size_t begin, size_t end, std::string_view row_data);
+
+        /// The most recent events, oldest first.
+        std::vector<Event> events() const;
+
+        std::span<const Sample> samples() const
+        {
+            return {reservoir.data(), number_of_samples};
+        }
+
+        uint64_t count(Discard reason) const
+        {
+            return counts[static_cast<size_t>(reason)];
+        }
+
+        uint64_t numberOfEvents() const
+        {
+            return number_of_events;
+        }
+
+        uint64_t numberOfRows() const
+        {
+            return number_of_rows;
+        }
+
+        void clear();
+
+    private:
+        uint64_t nextRandom();
+
+        std::vector<Event> ring;
+        /// Only the first `number_of_samples` are current, the others keep their strings for the next samples after `clear()`.
+        std::vector<Sample> reservoir;
+        size_t number_of_samples = 0;
+        size_t event_capacity;
+        size_t sample_capacity;
+
+        std::array<uint64_t, static_cast<size_t>(Discard::ESCAPE_CHARACTER_AT_VALUE_START) + 1> counts {};
+        uint64_t number_of_events = 0;
+        uint64_t number_of_rows = 0;
+        uint64_t random_state;
+    };
+}
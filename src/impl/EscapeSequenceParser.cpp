@@ -1,7 +1,6 @@
 #include <impl/EscapeSequenceParser.h>
 
 #include <string>
-#include <stdexcept>
 #include <util/ReadBuffer.h>
 
 inline bool isControlASCII(char c)
@@ -259,25 +258,16 @@ inline char parseEscapeSequence(char c)
 }
 
 /** Parse the escape sequence, which can be simple (one character after backslash) or more complex (multiple characters).
-  * It is assumed that the cursor is located on the `\` symbol
+  * It is assumed that the cursor is located on the `\` symbol. Returns false on malformed sequences, it never throws: the extractor
+  * hits this for every bad escape of dirty inputs.
   */
-template <typename Vector, typename ReturnType = void>
-static ReturnType parseComplexEscapeSequence(Vector & s, ReadBuffer & buf)
+static bool parseComplexEscapeSequence(std::string & s, ReadBuffer & buf)
 {
-    static constexpr bool throw_exception = std::is_same_v<ReturnType, void>;
-
-    auto error = [](const char * message [[maybe_unused]])
-    {
-        if constexpr (throw_exception)
-            throw std::runtime_error (message);
-        return ReturnType(false);
-    };
-
     ++buf.position();
 
     if (buf.eof())
     {
-        return error("Cannot parse escape sequence");
+        return false;
     }
 
     char char_after_backslash = *buf.position();
@@ -292,7 +282,7 @@ static ReturnType parseComplexEscapeSequence(Vector & s, ReadBuffer & buf)
 
         if (bytes_read != sizeof(hex_code))
         {
-            return error("Cannot parse escape sequence");
+            return false;
         }
 
         s.push_back(unhex2(hex_code));
@@ -325,12 +315,7 @@ static ReturnType parseComplexEscapeSequence(Vector & s, ReadBuffer & buf)
         ++buf.position();
     }
 
-    return ReturnType(true);
-}
-
-bool parseComplexEscapeSequence(std::string & s, ReadBuffer & buf)
-{
-    return parseComplexEscapeSequence<std::string, bool>(s, buf);
+    return true;
 }
 
 bool EscapeSequenceParser::parseComplex(std::string & s, ReadBuffer &buf)
@@ -6,5 +6,6 @@
 class EscapeSequenceParser
 {
 public:
+    /// Appends the decoded escape sequence at the cursor to `s`, returns false if it is malformed. Never throws.
     static bool parseComplex(std::string & s, ReadBuffer & buf);
 };
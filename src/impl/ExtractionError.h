@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <impl/Limits.h>
+
+namespace extractKV
+{
+    /*
+     * Reason extraction of a row failed, reported by `KeyValuePairExtractor::tryExtract` instead of an exception. `offset` is the byte
+     * offset into the row where extraction stopped.
+     * */
+    struct ExtractionError
+    {
+        enum class Code : uint8_t
+        {
+            PAST_END_OF_DATA,
+            KEY_LENGTH_LIMIT,
+            VALUE_LENGTH_LIMIT,
+            OUTPUT_BYTES_LIMIT,
+            NUMBER_OF_PAIRS_LIMIT
+        };
+
+        Code code;
+        size_t offset;
+
+        static constexpr Code fromLimit(Limits::Kind kind)
+        {
+            switch (kind)
+            {
+                case Limits::Kind::KEY_LENGTH: return Code::KEY_LENGTH_LIMIT;
+                case Limits::Kind::VALUE_LENGTH: return Code::VALUE_LENGTH_LIMIT;
+                case Limits::Kind::OUTPUT_BYTES: return Code::OUTPUT_BYTES_LIMIT;
+                case Limits::Kind::NONE:
+                case Limits::Kind::NUMBER_OF_PAIRS: return Code::NUMBER_OF_PAIRS_LIMIT;
+            }
+
+            return Code::NUMBER_OF_PAIRS_LIMIT;
+        }
+
+        static constexpr std::string_view toString(Code code)
+        {
+            switch (code)
+            {
+                case Code::PAST_END_OF_DATA: return "PAST_END_OF_DATA";
+                case Code::KEY_LENGTH_LIMIT: return "KEY_LENGTH_LIMIT";
+                case Code::VALUE_LENGTH_LIMIT: return "VALUE_LENGTH_LIMIT";
+                case Code::OUTPUT_BYTES_LIMIT: return "OUTPUT_BYTES_LIMIT";
+                case Code::NUMBER_OF_PAIRS_LIMIT: return "NUMBER_OF_PAIRS_LIMIT";
+            }
+
+            return "UNKNOWN";
+        }
+
+        bool operator==(const ExtractionError &) const = default;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <util/KeyHash.h>
+
+namespace extractKV
+{
+    /*
+     * Decorates a state handler `StringWriter` and hashes every chunk as it is appended, while the bytes just found by the symbol search
+     * are still in cache. `hash()` equals `KeyHash::hash(commit())`, so sinks can look keys up without going over them a second time.
+     *
+     * Both state handlers append a key at most once per chunk between resets (the no escaping writer replaces its view on `append`),
+     * so hashing the appended chunks hashes exactly the committed key.
+     * */
+    template <typename StringWriter>
+    class HashingStringWriter
+    {
+    public:
+        HashingStringWriter() = default;
+
+        /// Arguments are forwarded to the wrapped writer, e.g. a memory resource.
+        template <typename ... Args>
+        requires std::is_constructible_v<StringWriter, Args...>
+        explicit HashingStringWriter(Args && ... args)
+            : writer(std::forward<Args>(args)...)
+        {}
+
+        void append(std::string_view new_data)
+        {
+            hasher.update(new_data);
+            writer.append(new_data);
+        }
+
+        template <typename T>
+        void append(const T * begin, const T * end)
+        {
+            append(std::string_view {begin, end});
+        }
+
+        void reset()
+        {
+            hasher.reset();
+            writer.reset();
+        }
+
+        bool isEmpty() const
+        {
+            return writer.isEmpty();
+        }
+
+        std::string_view commit()
+        {
+            return writer.commit();
+        }
+
+        std::string_view uncommittedChunk() const
+        {
+            return writer.uncommittedChunk();
+        }
+
+        uint64_t hash() const
+        {
+            return hasher.finalize();
+        }
+
+    private:
+        StringWriter writer;
+        KeyHash::Hasher hasher;
+    };
+}
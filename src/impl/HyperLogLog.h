@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace extractKV
+{
+    /*
+     * Distinct count estimate of a stream of 64 bit hashes in 4 KiB, see Flajolet et al., "HyperLogLog: the analysis of a near-optimal
+     * cardinality estimation algorithm". The high `PRECISION` bits of a hash pick a register, which keeps the maximum number of
+     * leading zeros of the remaining bits plus one. The standard error is 1.04 / sqrt(2 ^ `PRECISION`), about 1.6%, counts up to
+     * three times the number of registers are estimated with linear counting.
+     * */
+    class HyperLogLog
+    {
+    public:
+        static constexpr size_t PRECISION = 12;
+        static constexpr size_t NUMBER_OF_REGISTERS = 1u << PRECISION;
+
+        void add(uint64_t hash)
+        {
+            auto & reg = registers[hash >> (64 - PRECISION)];
+            // A sentinel bit below the remaining bits keeps the rank finite when they are all zero
+            const auto rank = static_cast<uint8_t>(std::countl_zero((hash << PRECISION) | (1ull << (PRECISION - 1))) + 1);
+
+            if (rank > reg)
+            {
+                reg = rank;
+            }
+        }
+
+        double estimate() const
+        {
+            constexpr double m = NUMBER_OF_REGISTERS;
+            const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+            double sum = 0;
+            size_t zeros = 0;
+
+            static constexpr auto inverse_powers_of_two = []
+            {
+                std::array<double, 64> result {};
+
+                for (size_t i = 0; i < result.size(); ++i)
+                {
+                    result[i] = 1.0 / static_cast<double>(1ull << i);
+                }
+
+                return result;
+            }();
+
+            for (const auto reg : registers)
+            {
+                sum += inverse_powers_of_two[reg];
+                zeros += reg == 0;
+            }
+
+            // Linear counting is more accurate while there are empty registers, the raw estimate is biased up to a few times `m`
+            if (zeros)
+            {
+                const double linear = m * std::log(m / static_cast<double>(zeros));
+
+                if (linear <= 3 * m)
+                {
+                    return linear;
+                }
+            }
+
+            return alpha * m * m / sum;
+        }
+
+    private:
+        std::array<uint8_t, NUMBER_OF_REGISTERS> registers {};
+    };
+}
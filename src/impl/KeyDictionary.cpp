@@ -0,0 +1,133 @@
+#include <impl/KeyDictionary.h>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <util/KeyHash.h>
+
+namespace extractKV
+{
+    namespace
+    {
+        size_t validateCapacity(size_t max_number_of_keys)
+        {
+            if (max_number_of_keys >= KeyDictionary::INVALID_ID)
+            {
+                throw std::runtime_error ("Invalid arguments, key dictionary capacity must be smaller than "
+                                          + std::to_string(KeyDictionary::INVALID_ID));
+            }
+
+            return max_number_of_keys;
+        }
+
+        size_t numberOfSlots(size_t max_number_of_keys)
+        {
+            // Keep the load factor at or below 0.5 so that probe sequences stay short.
+            return std::bit_ceil(std::max<size_t>(16u, max_number_of_keys * 2));
+        }
+    }
+
+    KeyDictionary::KeyDictionary(size_t max_number_of_keys_)
+        : max_number_of_keys(validateCapacity(max_number_of_keys_)),
+        slot_mask(numberOfSlots(max_number_of_keys_) - 1),
+        slots(std::make_unique<std::atomic<const Entry *>[]>(slot_mask + 1)),
+        entries_by_id(std::make_unique<std::atomic<const Entry *>[]>(max_number_of_keys_))
+    {
+    }
+
+    KeyDictionary::~KeyDictionary()
+    {
+        for (size_t id = 0; id < number_of_keys.load(); ++id)
+        {
+            delete entries_by_id[id].load();
+        }
+    }
+
+    KeyDictionary::Id KeyDictionary::intern(std::string_view key, uint64_t hash)
+    {
+        size_t slot;
+
+        if (const auto * entry = probe(key, hash, slot))
+        {
+            return entry->id;
+        }
+
+        std::lock_guard lock(insert_mutex);
+
+        // Another thread might have inserted the key (or any other key in the same probe sequence) in the meantime.
+        if (const auto * entry = probe(key, hash, slot))
+        {
+            return entry->id;
+        }
+
+        const auto id = number_of_keys.load(std::memory_order_relaxed);
+
+        if (id >= max_number_of_keys)
+        {
+            return INVALID_ID;
+        }
+
+        const auto * entry = new Entry {hash, static_cast<Id>(id), std::string(key)};
+
+        entries_by_id[id].store(entry, std::memory_order_release);
+        slots[slot].store(entry, std::memory_order_release);
+        number_of_keys.store(id + 1, std::memory_order_release);
+
+        return entry->id;
+    }
+
+    KeyDictionary::Id KeyDictionary::intern(std::string_view key)
+    {
+        return intern(key, KeyHash::hash(key));
+    }
+
+    std::optional<KeyDictionary::Id> KeyDictionary::find(std::string_view key, uint64_t hash) const
+    {
+        size_t slot;
+
+        if (const auto * entry = probe(key, hash, slot))
+        {
+            return entry->id;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<KeyDictionary::Id> KeyDictionary::find(std::string_view key) const
+    {
+        return find(key, KeyHash::hash(key));
+    }
+
+    std::string_view KeyDictionary::key(Id id) const
+    {
+        return entries_by_id[id].load(std::memory_order_acquire)->key;
+    }
+
+    size_t KeyDictionary::size() const
+    {
+        return number_of_keys.load(std::memory_order_acquire);
+    }
+
+    size_t KeyDictionary::capacity() const
+    {
+        return max_number_of_keys;
+    }
+
+    const KeyDictionary::Entry * KeyDictionary::probe(std::string_view key, uint64_t hash, size_t & slot) const
+    {
+        for (slot = hash & slot_mask;; slot = (slot + 1) & slot_mask)
+        {
+            const auto * entry = slots[slot].load(std::memory_order_acquire);
+
+            if (!entry)
+            {
+                return nullptr;
+            }
+
+            if (entry->hash == hash && entry->key == key)
+            {
+                return entry;
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace extractKV
+{
+    /*
+     * Interns keys that repeat across rows, so that extracted rows can store a 32-bit id instead of a copy of the key and downstream
+     * code can compare keys as integers. Ids are dense, start at zero and are stable for the lifetime of the dictionary.
+     *
+     * The dictionary is meant to be shared by many extractors and threads. Lookups are lock-free: an open addressing table of atomic
+     * pointers to immutable entries, probed with the key hash (see `KeyHash`). Only inserting a new key takes a mutex, which is rare once
+     * the working set of keys has been seen. The capacity is fixed at construction, `intern` returns `INVALID_ID` once it is exhausted.
+     * */
+    class KeyDictionary
+    {
+    public:
+        using Id = uint32_t;
+
+        static constexpr Id INVALID_ID = std::numeric_limits<Id>::max();
+
+        explicit KeyDictionary(size_t max_number_of_keys_ = 4096);
+
+        KeyDictionary(const KeyDictionary &) = delete;
+
+        ~KeyDictionary();
+
+        /// Returns the id of `key`, interning it on first use. `hash` must be `KeyHash::hash(key)`.
+        Id intern(std::string_view key, uint64_t hash);
+
+        Id intern(std::string_view key);
+
+        std::optional<Id> find(std::string_view key, uint64_t hash) const;
+
+        std::optional<Id> find(std::string_view key) const;
+
+        /// `id` must have been returned by this dictionary.
+        std::string_view key(Id id) const;
+
+        size_t size() const;
+
+        size_t capacity() const;
+
+    private:
+        struct Entry
+        {
+            uint64_t hash;
+            Id id;
+            std::string key;
+        };
+
+        /// Returns the entry for `key` or the index of the empty slot where it would be inserted.
+        const Entry * probe(std::string_view key, uint64_t hash, size_t & slot) const;
+
+        const size_t max_number_of_keys;
+        const size_t slot_mask;
+
+        std::unique_ptr<std::atomic<const Entry *>[]> slots;
+        std::unique_ptr<std::atomic<const Entry *>[]> entries_by_id;
+        std::atomic<size_t> number_of_keys = 0;
+
+        std::mutex insert_mutex;
+    };
+}
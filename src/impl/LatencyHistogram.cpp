@@ -0,0 +1,133 @@
+#include <impl/LatencyHistogram.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace extractKV
+{
+    namespace
+    {
+        size_t currentThreadShard()
+        {
+            static std::atomic<size_t> next_shard = 0;
+            thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % LatencyHistogram::NUMBER_OF_SHARDS;
+
+            return shard;
+        }
+    }
+
+    void LatencyHistogram::Snapshot::add(size_t bucket, uint64_t count)
+    {
+        counts[bucket] += count;
+        total += count;
+    }
+
+    void LatencyHistogram::Snapshot::merge(const Snapshot & other)
+    {
+        for (size_t bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+        {
+            counts[bucket] += other.counts[bucket];
+        }
+
+        total += other.total;
+    }
+
+    uint64_t LatencyHistogram::Snapshot::percentile(double quantile) const
+    {
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total))));
+
+        uint64_t seen = 0;
+
+        for (size_t bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+        {
+            seen += counts[bucket];
+
+            if (seen >= rank)
+            {
+                return bucketUpperBound(bucket);
+            }
+        }
+
+        return bucketUpperBound(NUMBER_OF_BUCKETS - 1);
+    }
+
+    LatencyHistogram::LatencyHistogram()
+        : shards(std::make_unique<Shard[]>(NUMBER_OF_SHARDS))
+    {
+    }
+
+    void LatencyHistogram::record(uint64_t nanoseconds)
+    {
+        shards[currentThreadShard()].counts[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+    {
+        Snapshot result;
+
+        for (size_t shard = 0; shard < NUMBER_OF_SHARDS; ++shard)
+        {
+            for (size_t bucket = 0; bucket < NUMBER_OF_BUCKETS; ++bucket)
+            {
+                if (const auto count = shards[shard].counts[bucket].load(std::memory_order_relaxed))
+                {
+                    result.add(bucket, count);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void LatencyHistogram::reset()
+    {
+        for (size_t shard = 0; shard < NUMBER_OF_SHARDS; ++shard)
+        {
+            for (auto & count : shards[shard].counts)
+            {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t LatencyHistogram::bucketOf(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return value;
+        }
+
+        // `value >> shift` is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+        const size_t shift = std::bit_width(value) - 1 - SUB_BUCKET_BITS;
+
+        return shift * SUB_BUCKETS + (value >> shift);
+    }
+
+    uint64_t LatencyHistogram::bucketLowerBound(size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        const size_t shift = bucket / SUB_BUCKETS - 1;
+
+        return static_cast<uint64_t>(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    uint64_t LatencyHistogram::bucketUpperBound(size_t bucket)
+    {
+        if (bucket + 1 == NUMBER_OF_BUCKETS)
+        {
+            return UINT64_MAX;
+        }
+
+        return bucketLowerBound(bucket + 1) - 1;
+    }
+}
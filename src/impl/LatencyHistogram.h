@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace extractKV
+{
+    /*
+     * Histogram of extraction latencies in nanoseconds, see `KeyValuePairExtractorBuilder::withLatencyHistogram`. Meant to find the
+     * rows behind tail latency (escape dense rows, huge values) that mean throughput numbers hide.
+     *
+     * Buckets are log-linear like HDR histograms: values below `SUB_BUCKETS` have a bucket each, above that every power of two is split
+     * into `SUB_BUCKETS` linear buckets, so percentiles are within 1 / `SUB_BUCKETS` (6.25%) of the exact value over the whole range.
+     *
+     * Recording is lock-free: each thread increments relaxed atomic counters of one of `NUMBER_OF_SHARDS` cache line aligned shards,
+     * picked once per thread. `snapshot()` sums the shards into a plain `Snapshot`, which can be merged with the snapshots of other
+     * histograms, e.g. of other processes or time windows.
+     * */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 4;
+        static constexpr size_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+        static constexpr size_t NUMBER_OF_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+        static constexpr size_t NUMBER_OF_SHARDS = 16;
+
+        class Snapshot
+        {
+        public:
+            void add(size_t bucket, uint64_t count);
+
+            void merge(const Snapshot & other);
+
+            uint64_t count() const
+            {
+                return total;
+            }
+
+            /// Upper bound of the bucket holding the value at `quantile` (in [0, 1]), zero if nothing was recorded.
+            uint64_t percentile(double quantile) const;
+
+            const std::array<uint64_t, NUMBER_OF_BUCKETS> & buckets() const
+            {
+                return counts;
+            }
+
+        private:
+            std::array<uint64_t, NUMBER_OF_BUCKETS> counts {};
+            uint64_t total = 0;
+        };
+
+        LatencyHistogram();
+
+        void record(uint64_t nanoseconds);
+
+        Snapshot snapshot() const;
+
+        void reset();
+
+        static size_t bucketOf(uint64_t value);
+
+        /// Smallest and largest value of `bucket`.
+        static uint64_t bucketLowerBound(size_t bucket);
+
+        static uint64_t bucketUpperBound(size_t bucket);
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> counts {};
+        };
+
+        std::unique_ptr<Shard[]> shards;
+    };
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace extractKV
+{
+    /*
+     * Decorates a `StringWriter` with a length limit, see `Limits`. Appends past the limit are cut, so the wrapped writer never holds
+     * more than `max_length` bytes, and `exceededLimit()` tells the extractor to apply the policy when the pair is flushed.
+     *
+     * Like `HashingStringWriter`, it relies on a token being appended chunk by chunk between resets.
+     * */
+    template <typename StringWriter>
+    class LimitedStringWriter
+    {
+    public:
+        /// Further arguments are forwarded to the wrapped writer, e.g. a memory resource.
+        template <typename ... Args>
+        requires std::is_constructible_v<StringWriter, Args...>
+        explicit LimitedStringWriter(uint64_t max_length_, Args && ... args)
+            : writer(std::forward<Args>(args)...), max_length(max_length_)
+        {}
+
+        void append(std::string_view new_data)
+        {
+            if (new_data.size() > max_length - length)
+            {
+                exceeded_limit = true;
+                new_data = new_data.substr(0, max_length - length);
+            }
+
+            length += new_data.size();
+            writer.append(new_data);
+        }
+
+        template <typename T>
+        void append(const T * begin, const T * end)
+        {
+            append(std::string_view {begin, end});
+        }
+
+        void reset()
+        {
+            length = 0;
+            exceeded_limit = false;
+            writer.reset();
+        }
+
+        bool isEmpty() const
+        {
+            return writer.isEmpty();
+        }
+
+        std::string_view commit()
+        {
+            return writer.commit();
+        }
+
+        std::string_view uncommittedChunk() const
+        {
+            return writer.uncommittedChunk();
+        }
+
+        uint64_t hash() const requires requires (const StringWriter & w) { w.hash(); }
+        {
+            return writer.hash();
+        }
+
+        bool exceededLimit() const
+        {
+            return exceeded_limit;
+        }
+
+    private:
+        StringWriter writer;
+        uint64_t max_length;
+        uint64_t length = 0;
+        bool exceeded_limit = false;
+    };
+}
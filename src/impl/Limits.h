@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace extractKV
+{
+    /*
+     * Per row resource limits. Each limit has its own policy for what happens once it is exceeded:
+     *  - `TRUNCATE`: keys and values are cut at the limit. For the output size and the number of pairs it is the same as `STOP_ROW`.
+     *  - `SKIP_PAIR`: the offending pair is dropped and extraction goes on. For the number of pairs it is the same as `STOP_ROW`.
+     *  - `STOP_ROW`: extraction stops, the pairs extracted so far are the result.
+     *  - `ERROR`: extraction stops and reports the exceeded limit, the legacy APIs turn it into an exception.
+     *
+     * Lengths are enforced by the string writers, which never store more than the limit, so a huge malformed row can't exhaust memory.
+     * The output size is the sum of key and value lengths of the extracted pairs.
+     * */
+    struct Limits
+    {
+        enum class Kind : uint8_t
+        {
+            NONE,
+            KEY_LENGTH,
+            VALUE_LENGTH,
+            OUTPUT_BYTES,
+            NUMBER_OF_PAIRS
+        };
+
+        enum class Policy : uint8_t
+        {
+            TRUNCATE,
+            SKIP_PAIR,
+            STOP_ROW,
+            ERROR
+        };
+
+        struct Limit
+        {
+            static constexpr auto UNLIMITED = std::numeric_limits<uint64_t>::max();
+
+            uint64_t max = UNLIMITED;
+            Policy policy = Policy::ERROR;
+
+            bool isSet() const
+            {
+                return max != UNLIMITED;
+            }
+        };
+
+        Limit key_length;
+        Limit value_length;
+        Limit output_bytes;
+        Limit number_of_pairs;
+
+        bool limitsLengths() const
+        {
+            return key_length.isSet() || value_length.isSet();
+        }
+
+        const Limit & get(Kind kind) const
+        {
+            switch (kind)
+            {
+                case Kind::KEY_LENGTH: return key_length;
+                case Kind::VALUE_LENGTH: return value_length;
+                case Kind::OUTPUT_BYTES: return output_bytes;
+                case Kind::NONE:
+                case Kind::NUMBER_OF_PAIRS: return number_of_pairs;
+            }
+
+            return number_of_pairs;
+        }
+
+        std::string describe(Kind kind) const
+        {
+            switch (kind)
+            {
+                case Kind::NONE: return "No limit exceeded";
+                case Kind::KEY_LENGTH: return "Key length exceeded the limit of " + std::to_string(key_length.max) + " bytes";
+                case Kind::VALUE_LENGTH: return "Value length exceeded the limit of " + std::to_string(value_length.max) + " bytes";
+                case Kind::OUTPUT_BYTES: return "Output size exceeded the limit of " + std::to_string(output_bytes.max) + " bytes";
+                case Kind::NUMBER_OF_PAIRS: return "Number of pairs produced exceeded the limit of " + std::to_string(number_of_pairs.max);
+            }
+
+            return {};
+        }
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <util/find_symbols.h>
+#include <util/SearchSymbolsCalibration.h>
 
 #include <iterator>
 #include <vector>
@@ -11,7 +12,7 @@ namespace extractKV
 
 /*
 * `StateHandlerImpl` makes use of string search algorithms to find delimiters. This class creates the needles for each state
-*  based on the contents of `Configuration`.
+*  based on the contents of `Configuration`. Each needle set gets the search kernel that is fastest for its size on the running CPU.
 * */
     template <bool WITH_ESCAPING>
     class NeedleFactory
@@ -33,7 +34,7 @@ namespace extractKV
                 needles.push_back('\\');
             }
 
-            return SearchSymbols {std::string{needles.data(), needles.size()}};
+            return SearchSymbolsCalibration::calibrate(std::string{needles.data(), needles.size()});
         }
 
         SearchSymbols getReadKeyNeedles(const Configuration & extractor_configuration)
@@ -53,7 +54,7 @@ namespace extractKV
                 needles.push_back('\\');
             }
 
-            return SearchSymbols {std::string{needles.data(), needles.size()}};
+            return SearchSymbolsCalibration::calibrate(std::string{needles.data(), needles.size()});
         }
 
         SearchSymbols getReadValueNeedles(const Configuration & extractor_configuration)
@@ -72,7 +73,7 @@ namespace extractKV
                 needles.push_back('\\');
             }
 
-            return SearchSymbols {std::string{needles.data(), needles.size()}};
+            return SearchSymbolsCalibration::calibrate(std::string{needles.data(), needles.size()});
         }
 
         SearchSymbols getReadQuotedNeedles(const Configuration & extractor_configuration)
@@ -88,7 +89,7 @@ namespace extractKV
                 needles.push_back('\\');
             }
 
-            return SearchSymbols {std::string{needles.data(), needles.size()}};
+            return SearchSymbolsCalibration::calibrate(std::string{needles.data(), needles.size()});
         }
     };
 
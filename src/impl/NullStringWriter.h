@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace extractKV
+{
+    /*
+     * `StringWriter` that stores nothing, for extraction modes that only look at the state transitions, see `ValidatingSink`. It keeps
+     * track of the appended length because `readQuotedKey` drops empty keys.
+     * */
+    class NullStringWriter
+    {
+    public:
+        void append(std::string_view new_data)
+        {
+            length += new_data.size();
+        }
+
+        template <typename T>
+        void append(const T * begin, const T * end)
+        {
+            length += end - begin;
+        }
+
+        void reset()
+        {
+            length = 0;
+        }
+
+        bool isEmpty() const
+        {
+            return length == 0;
+        }
+
+        std::string_view commit()
+        {
+            reset();
+            return {};
+        }
+
+        std::string_view uncommittedChunk() const
+        {
+            return {};
+        }
+
+    private:
+        size_t length = 0;
+    };
+}
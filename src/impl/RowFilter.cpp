@@ -0,0 +1,72 @@
+#include <impl/RowFilter.h>
+
+#include <stdexcept>
+
+namespace extractKV
+{
+    bool RowFilter::Predicate::acceptsValue(std::string_view pair_value) const
+    {
+        switch (kind)
+        {
+            case Kind::EQUALS:
+                return pair_value == value;
+            case Kind::NOT_EQUALS:
+                return pair_value != value;
+            case Kind::PRESENT:
+                return true;
+            case Kind::ABSENT:
+                return false;
+        }
+
+        return false;
+    }
+
+    bool RowFilter::Predicate::acceptsMissingKey() const
+    {
+        return kind == Kind::NOT_EQUALS || kind == Kind::ABSENT;
+    }
+
+    void RowFilter::add(std::string_view expression)
+    {
+        add(parse(expression));
+    }
+
+    void RowFilter::add(Predicate predicate)
+    {
+        if (predicates.size() == MAX_NUMBER_OF_PREDICATES)
+        {
+            throw std::runtime_error ("Invalid arguments, a row filter can contain at most " + std::to_string(MAX_NUMBER_OF_PREDICATES) + " predicates");
+        }
+
+        predicates.push_back(std::move(predicate));
+    }
+
+    RowFilter::Predicate RowFilter::parse(std::string_view expression)
+    {
+        Predicate predicate;
+
+        if (const auto position = expression.find("!="); position != std::string_view::npos)
+        {
+            predicate = {Predicate::Kind::NOT_EQUALS, std::string(expression.substr(0, position)), std::string(expression.substr(position + 2))};
+        }
+        else if (const auto equals_position = expression.find('='); equals_position != std::string_view::npos)
+        {
+            predicate = {Predicate::Kind::EQUALS, std::string(expression.substr(0, equals_position)), std::string(expression.substr(equals_position + 1))};
+        }
+        else if (expression.starts_with('!'))
+        {
+            predicate = {Predicate::Kind::ABSENT, std::string(expression.substr(1)), {}};
+        }
+        else
+        {
+            predicate = {Predicate::Kind::PRESENT, std::string(expression), {}};
+        }
+
+        if (predicate.key.empty())
+        {
+            throw std::runtime_error ("Invalid filter expression '" + std::string(expression) + "', the key is empty");
+        }
+
+        return predicate;
+    }
+}
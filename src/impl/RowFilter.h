@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace extractKV
+{
+    /*
+     * Conjunction of predicates on the pairs of a row, evaluated while the row is being extracted so that rows can be dropped as soon
+     * as a predicate fails, without materializing the remaining pairs. See `FilteringSink`.
+     *
+     * Predicates are written as:
+     *  - `key=value`: `key` is present and its value is `value`.
+     *  - `key!=value`: `key` is absent or its value is not `value`.
+     *  - `key`: `key` is present.
+     *  - `!key`: `key` is absent.
+     *
+     * A predicate is decided by the first occurrence of its key in a row, duplicated keys are not looked at again. This lets a row be
+     * dropped at the first value that fails, but it differs from the outputs, which keep the last value of a repeated key:
+     * `level=ERROR level=INFO` passes `level=ERROR`. Keys and values are compared after unescaping and unquoting.
+     * */
+    class RowFilter
+    {
+    public:
+        struct Predicate
+        {
+            enum class Kind
+            {
+                EQUALS,
+                NOT_EQUALS,
+                PRESENT,
+                ABSENT
+            };
+
+            Kind kind;
+            std::string key;
+            std::string value;
+
+            /// Outcome once the first occurrence of `key` has value `pair_value`.
+            bool acceptsValue(std::string_view pair_value) const;
+
+            /// Outcome if the row has no `key` at all.
+            bool acceptsMissingKey() const;
+        };
+
+        /// Per row evaluation state is kept in a 64 bit mask.
+        static constexpr auto MAX_NUMBER_OF_PREDICATES = 64u;
+
+        /// Parses and adds a predicate, throws on syntax errors.
+        void add(std::string_view expression);
+
+        void add(Predicate predicate);
+
+        bool empty() const
+        {
+            return predicates.empty();
+        }
+
+        const std::vector<Predicate> & getPredicates() const
+        {
+            return predicates;
+        }
+
+        static Predicate parse(std::string_view expression);
+
+    private:
+        std::vector<Predicate> predicates;
+    };
+}
@@ -0,0 +1,52 @@
+#include <impl/RowShape.h>
+
+namespace extractKV
+{
+    bool RowShape::beginRow()
+    {
+        if (cooldown_rows)
+        {
+            --cooldown_rows;
+            return false;
+        }
+
+        if (window_checks >= CHECK_WINDOW)
+        {
+            const bool low_hit_rate = window_hits * 2 < window_checks;
+
+            window_hits = 0;
+            window_checks = 0;
+
+            if (low_hit_rate)
+            {
+                forget(0);
+                cooldown_rows = COOLDOWN_ROWS;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void RowShape::remember(size_t index, std::string_view raw_key)
+    {
+        forget(index);
+
+        if (index != key_ends.size() || raw_key.empty() || raw_key.find('\\') != std::string_view::npos)
+        {
+            return;
+        }
+
+        keys.append(raw_key);
+        key_ends.push_back(keys.size());
+    }
+
+    void RowShape::forget(size_t index)
+    {
+        if (index < key_ends.size())
+        {
+            key_ends.resize(index);
+            keys.resize(index ? key_ends.back() : 0);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace extractKV
+{
+    /*
+     * Remembers the key sequence of the previous row, e.g. `ts= level= msg= user= latency=` for log lines that always print the same
+     * keys in the same order. While reading the next row, the extractor first checks whether the input at the start of the n-th key
+     * is the n-th remembered key followed by the key value delimiter, a single `memcmp`, and only runs the general `readKey` search
+     * on a mismatch.
+     *
+     * Only keys read by `readKey` are remembered, and only if they contain no backslash (a possible escape sequence). Those contain no
+     * control character, so a match yields exactly what `readKey` would. Remembering stops at the first quoted or escaped key of a row.
+     *
+     * The hit rate is measured over windows of `CHECK_WINDOW` checks. If less than half of the checks hit, the shape is dropped and
+     * not used for the next `COOLDOWN_ROWS` rows, so rows without a stable shape only pay for the checks of one window.
+     *
+     * A `RowShape` is mutable per row state: keep one per thread and per extractor configuration, see `KeyValuePairExtractorHandle`.
+     * */
+    class RowShape
+    {
+    public:
+        static constexpr uint64_t CHECK_WINDOW = 256;
+        static constexpr uint64_t COOLDOWN_ROWS = 1024;
+
+        /// Returns whether the shape is used for the row that starts.
+        bool beginRow();
+
+        /// Number of remembered keys.
+        size_t size() const
+        {
+            return key_ends.size();
+        }
+
+        /// Length of the remembered key `index` if `data` starts with it followed by `key_value_delimiter`, zero otherwise.
+        size_t match(size_t index, std::string_view data, char key_value_delimiter)
+        {
+            const size_t begin = index ? key_ends[index - 1] : 0;
+            const size_t length = key_ends[index] - begin;
+
+            ++window_checks;
+            ++total_checks;
+
+            if (data.size() > length && data[length] == key_value_delimiter && memcmp(data.data(), keys.data() + begin, length) == 0)
+            {
+                ++window_hits;
+                ++total_hits;
+                return length;
+            }
+
+            return 0;
+        }
+
+        /// Remembers `raw_key`, as read by `readKey`, as key `index` and forgets the keys that followed it.
+        void remember(size_t index, std::string_view raw_key);
+
+        /// Forgets key `index` and the keys that followed it.
+        void forget(size_t index);
+
+        uint64_t hits() const
+        {
+            return total_hits;
+        }
+
+        uint64_t checks() const
+        {
+            return total_checks;
+        }
+
+    private:
+        std::string keys;
+        std::vector<size_t> key_ends;
+
+        uint64_t window_hits = 0;
+        uint64_t window_checks = 0;
+        uint64_t cooldown_rows = 0;
+
+        uint64_t total_hits = 0;
+        uint64_t total_checks = 0;
+    };
+}
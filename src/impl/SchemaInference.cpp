@@ -0,0 +1,156 @@
+#include <impl/SchemaInference.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace extractKV
+{
+    namespace
+    {
+        constexpr ValueType INFERRED_TYPES[] = {ValueType::INT64, ValueType::DOUBLE, ValueType::BOOL, ValueType::TIMESTAMP};
+
+        constexpr uint8_t typeBit(ValueType type)
+        {
+            return static_cast<uint8_t>(1u << static_cast<uint8_t>(type));
+        }
+
+        constexpr uint8_t ALL_INFERRED_TYPES
+            = typeBit(ValueType::INT64) | typeBit(ValueType::DOUBLE) | typeBit(ValueType::BOOL) | typeBit(ValueType::TIMESTAMP);
+
+        bool parsesAs(ValueType type, std::string_view value)
+        {
+            int64_t integer;
+            double floating;
+            bool boolean;
+
+            switch (type)
+            {
+                case ValueType::INT64: return parseInt64(value, integer);
+                case ValueType::DOUBLE: return parseDouble(value, floating);
+                case ValueType::BOOL: return parseBool(value, boolean);
+                case ValueType::TIMESTAMP: return parseTimestamp(value, integer);
+                case ValueType::STRING: return true;
+            }
+
+            return false;
+        }
+    }
+
+    void SchemaInference::add(const ColumnarBatch & batch)
+    {
+        if (!batch.isMap())
+        {
+            throw std::runtime_error ("Schema inference needs batches of the map layout");
+        }
+
+        const auto & map_offsets = batch.getMapOffsets();
+        const auto & batch_keys = batch.getKeys();
+        const auto & batch_values = batch.getValues();
+
+        size_t row = 0;
+
+        for (size_t entry = 0; entry < batch_keys.size(); ++entry)
+        {
+            while (static_cast<size_t>(map_offsets[row + 1]) <= entry)
+            {
+                ++row;
+            }
+
+            auto & statistics = statisticsOf(batch_keys.value(entry), entry - map_offsets[row]);
+            const auto value = batch_values.value(entry);
+
+            // The map layout keeps one entry per key and row
+            ++statistics.rows;
+            statistics.min_length = std::min(statistics.min_length, value.size());
+            statistics.max_length = std::max(statistics.max_length, value.size());
+            statistics.distinct_values.add(KeyHash::hash(value));
+
+            if (value.empty())
+            {
+                continue;
+            }
+
+            if (statistics.non_empty_values++ == 0)
+            {
+                statistics.candidate_types = ALL_INFERRED_TYPES;
+            }
+
+            auto remaining_types = statistics.candidate_types;
+
+            // An integer is a valid double as well
+            if ((remaining_types & typeBit(ValueType::INT64)) && parsesAs(ValueType::INT64, value))
+            {
+                remaining_types &= ~(typeBit(ValueType::INT64) | typeBit(ValueType::DOUBLE));
+            }
+
+            for (const auto type : INFERRED_TYPES)
+            {
+                if ((remaining_types & typeBit(type)) && !parsesAs(type, value))
+                {
+                    statistics.candidate_types &= ~typeBit(type);
+                }
+            }
+        }
+
+        number_of_rows += map_offsets.size() - 1u;
+    }
+
+    std::vector<SchemaInference::Column> SchemaInference::getColumns() const
+    {
+        std::vector<Column> columns;
+
+        for (const auto & statistics : keys)
+        {
+            auto & column = columns.emplace_back();
+
+            column.key = statistics.key;
+            column.presence = number_of_rows ? static_cast<double>(statistics.rows) / static_cast<double>(number_of_rows) : 0;
+            column.min_length = statistics.min_length;
+            column.max_length = statistics.max_length;
+            column.distinct_values = statistics.distinct_values.estimate();
+
+            for (const auto type : INFERRED_TYPES)
+            {
+                if (statistics.candidate_types & typeBit(type))
+                {
+                    column.type = type;
+                    break;
+                }
+            }
+
+            column.low_cardinality = column.type == ValueType::STRING && column.distinct_values <= LOW_CARDINALITY_MAX_DISTINCT
+                && column.distinct_values * LOW_CARDINALITY_MIN_REPEATS <= static_cast<double>(statistics.rows);
+        }
+
+        return columns;
+    }
+
+    SchemaInference::KeyStatistics & SchemaInference::statisticsOf(std::string_view key, size_t position)
+    {
+        if (position >= previous_row_keys.size())
+        {
+            previous_row_keys.resize(position + 1u, keys.size());
+        }
+
+        auto & previous = previous_row_keys[position];
+
+        // Rows of the same shape have the same key at the same position
+        if (previous < keys.size() && keys[previous].key == key)
+        {
+            return keys[previous];
+        }
+
+        if (const auto it = key_indices.find(key); it != key_indices.end())
+        {
+            previous = it->second;
+            return keys[it->second];
+        }
+
+        auto & statistics = keys.emplace_back();
+        statistics.key = std::string(key);
+        key_indices.emplace(statistics.key, keys.size() - 1u);
+        previous = keys.size() - 1u;
+
+        return statistics;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <impl/ColumnarBatch.h>
+#include <impl/HyperLogLog.h>
+#include <impl/TypedValue.h>
+#include <util/KeyHash.h>
+
+namespace extractKV
+{
+    /*
+     * Collects per key statistics over a sample of rows, to derive the columns, types and low cardinality columns of a projected
+     * `ColumnarBatch` instead of writing them by hand. Rows are added as map layout batches, so that sampling costs one extraction per
+     * row without building a `Response`.
+     *
+     * Per key it tracks the number of rows with the key, min and max value length, a `HyperLogLog` distinct count estimate and the
+     * types all non empty values parse as. The inferred type is the first of `INT64`, `DOUBLE`, `BOOL` and `TIMESTAMP` that fits all
+     * values, empty values are left out as they end up null in a typed column anyway. A string key is low cardinality when its
+     * estimated distinct count is at most `LOW_CARDINALITY_MAX_DISTINCT` and its values repeat at least `LOW_CARDINALITY_MIN_REPEATS`
+     * times on average.
+     * */
+    class SchemaInference
+    {
+    public:
+        static constexpr double LOW_CARDINALITY_MAX_DISTINCT = 1024;
+        static constexpr double LOW_CARDINALITY_MIN_REPEATS = 4;
+
+        struct KeyStatistics
+        {
+            std::string key;
+            uint64_t rows = 0;
+            uint64_t non_empty_values = 0;
+            size_t min_length = SIZE_MAX;
+            size_t max_length = 0;
+
+            /// Bit per `ValueType` that every non empty value so far parses as.
+            uint8_t candidate_types = 0;
+
+            HyperLogLog distinct_values;
+        };
+
+        struct Column
+        {
+            std::string key;
+            double presence = 0;
+            ValueType type = ValueType::STRING;
+            size_t min_length = 0;
+            size_t max_length = 0;
+            double distinct_values = 0;
+            bool low_cardinality = false;
+        };
+
+        /// Adds the rows of a map layout batch.
+        void add(const ColumnarBatch & batch);
+
+        uint64_t numberOfRows() const
+        {
+            return number_of_rows;
+        }
+
+        /// Keys in order of their first occurrence.
+        std::vector<Column> getColumns() const;
+
+    private:
+        struct KeyHasher
+        {
+            size_t operator()(std::string_view key) const
+            {
+                return KeyHash::hash(key);
+            }
+        };
+
+        /// Statistics of `key`, the `position`-th key of its row.
+        KeyStatistics & statisticsOf(std::string_view key, size_t position);
+
+        /// A deque keeps the keys in place, `key_indices` views them.
+        std::deque<KeyStatistics> keys;
+        std::unordered_map<std::string_view, size_t, KeyHasher> key_indices;
+
+        /// Index in `keys` of the key at each position of the previous row.
+        std::vector<size_t> previous_row_keys;
+        uint64_t number_of_rows = 0;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <impl/TypedValue.h>
+
+namespace extractKV
+{
+    /*
+     * Arrow fixed width array of parsed values, see `ColumnarBatch`: `Int64`, `Float64`, `Bool` or `Timestamp(MICROSECOND, UTC)`.
+     * Rows without the key and rows whose value isn't valid for the type are null, the latter are also marked in `invalid`.
+     * */
+    struct TypedColumn
+    {
+        ValueType type = ValueType::INT64;
+
+        /// Little endian `int64_t` or `double` per row, or one bit per row for `BOOL`, zero for nulls.
+        std::vector<uint8_t> data;
+
+        /// One bit per row, least significant bit first, like `Utf8Column::validity`.
+        std::vector<uint8_t> validity;
+        size_t null_count = 0;
+
+        /// One bit per row, set for rows whose value couldn't be parsed.
+        std::vector<uint8_t> invalid;
+        size_t invalid_count = 0;
+
+        size_t rows = 0;
+
+        size_t size() const
+        {
+            return rows;
+        }
+
+        bool isNull(size_t row) const
+        {
+            return null_count && !(validity[row / 8] & (1u << (row % 8)));
+        }
+
+        bool isInvalid(size_t row) const
+        {
+            return invalid_count && (invalid[row / 8] & (1u << (row % 8)));
+        }
+
+        int64_t int64At(size_t row) const
+        {
+            int64_t value;
+            memcpy(&value, data.data() + row * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        double doubleAt(size_t row) const
+        {
+            double value;
+            memcpy(&value, data.data() + row * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        bool boolAt(size_t row) const
+        {
+            return data[row / 8] & (1u << (row % 8));
+        }
+    };
+}
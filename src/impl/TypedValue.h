@@ -0,0 +1,408 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace extractKV
+{
+    /*
+     * Types values of a `ColumnarBatch` column can be parsed into, and the parsers. They are exact: a value with anything but the
+     * expected syntax, or out of range, is invalid rather than partially parsed.
+     *
+     * - `INT64`: optional sign and decimal digits. Digits are converted eight at a time with SWAR arithmetic.
+     * - `DOUBLE`: anything `std::from_chars` accepts, plus a leading `+`.
+     * - `BOOL`: `true`, `false`, `yes`, `no` in any case, `1` and `0`.
+     * - `TIMESTAMP`: microseconds since the epoch, UTC. Either ISO 8601, `YYYY-MM-DD[(T| )hh:mm:ss[.fraction]][Z|(+|-)hh[:]mm]`,
+     *   or seconds since the epoch with an optional fraction. Digits beyond microseconds are truncated.
+     * */
+    enum class ValueType : uint8_t
+    {
+        STRING,
+        INT64,
+        DOUBLE,
+        BOOL,
+        TIMESTAMP,
+    };
+
+    inline std::string_view valueTypeName(ValueType type)
+    {
+        switch (type)
+        {
+            case ValueType::STRING: return "string";
+            case ValueType::INT64: return "int64";
+            case ValueType::DOUBLE: return "double";
+            case ValueType::BOOL: return "bool";
+            case ValueType::TIMESTAMP: return "timestamp";
+        }
+
+        return "unknown";
+    }
+
+    inline ValueType parseValueType(std::string_view name)
+    {
+        for (const auto type : {ValueType::STRING, ValueType::INT64, ValueType::DOUBLE, ValueType::BOOL, ValueType::TIMESTAMP})
+        {
+            if (valueTypeName(type) == name)
+            {
+                return type;
+            }
+        }
+
+        throw std::runtime_error ("Invalid arguments, unknown type '" + std::string(name)
+                                  + "', expected string, int64, double, bool or timestamp");
+    }
+
+    namespace detail
+    {
+        inline bool isEightDigits(uint64_t chunk)
+        {
+            // A byte is a digit if neither subtracting '0' nor adding 0x46 ('9' + 0x46 = 0x7F) carries into its top bit
+            return !(((chunk + 0x4646464646464646ull) | (chunk - 0x3030303030303030ull)) & 0x8080808080808080ull);
+        }
+
+        /// Value of eight ASCII digits, the first one in the lowest byte. See Lemire, "Quickly parsing eight digits".
+        inline uint32_t parseEightDigits(uint64_t chunk)
+        {
+            chunk -= 0x3030303030303030ull;
+            chunk = (chunk * 10) + (chunk >> 8);
+            chunk = (((chunk & 0x000000FF000000FFull) * 0x000F424000000064ull)
+                     + (((chunk >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+
+            return static_cast<uint32_t>(chunk);
+        }
+
+        /// Parses the digits at `pos` and returns the position after them, `number_of_digits` is 20 if there are more than 19.
+        inline const char * parseDigits(const char * pos, const char * end, uint64_t & result, size_t & number_of_digits)
+        {
+            const auto * begin = pos;
+            result = 0;
+
+            if constexpr (std::endian::native == std::endian::little)
+            {
+                while (end - pos >= 8)
+                {
+                    uint64_t chunk;
+                    memcpy(&chunk, pos, sizeof(chunk));
+
+                    if (!isEightDigits(chunk))
+                    {
+                        break;
+                    }
+
+                    result = result * 100000000u + parseEightDigits(chunk);
+                    pos += 8;
+
+                    // Another eight digits could overflow, the rest is parsed one digit at a time with the length check below
+                    if (pos - begin >= 16)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            for (; pos != end && static_cast<unsigned char>(*pos - '0') < 10; ++pos)
+            {
+                if (pos - begin >= 19)
+                {
+                    // May not fit in uint64_t
+                    number_of_digits = 20;
+                    return pos;
+                }
+
+                result = result * 10 + static_cast<unsigned char>(*pos - '0');
+            }
+
+            number_of_digits = pos - begin;
+            return pos;
+        }
+
+        inline bool equalsIgnoreCase(std::string_view value, std::string_view lower_case)
+        {
+            if (value.size() != lower_case.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if ((value[i] | 0x20) != lower_case[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Parses exactly `count` digits.
+        inline bool parseFixedDigits(const char *& pos, const char * end, size_t count, int64_t & result)
+        {
+            if (static_cast<size_t>(end - pos) < count)
+            {
+                return false;
+            }
+
+            result = 0;
+
+            for (size_t i = 0; i < count; ++i, ++pos)
+            {
+                const auto digit = static_cast<unsigned char>(*pos - '0');
+
+                if (digit >= 10)
+                {
+                    return false;
+                }
+
+                result = result * 10 + digit;
+            }
+
+            return true;
+        }
+
+        /// Up to six digits of a fraction as microseconds, more digits are truncated.
+        inline bool parseMicroseconds(const char *& pos, const char * end, int64_t & microseconds)
+        {
+            const auto * begin = pos;
+            microseconds = 0;
+
+            for (; pos != end && static_cast<unsigned char>(*pos - '0') < 10; ++pos)
+            {
+                if (pos - begin < 6)
+                {
+                    microseconds = microseconds * 10 + (*pos - '0');
+                }
+            }
+
+            for (auto digits = pos - begin; digits < 6; ++digits)
+            {
+                microseconds *= 10;
+            }
+
+            return pos != begin;
+        }
+
+        /// Days since 1970-01-01 of a proleptic Gregorian date, see Howard Hinnant's `days_from_civil`.
+        inline int64_t daysFromCivil(int64_t year, int64_t month, int64_t day)
+        {
+            year -= month <= 2;
+            const auto era = (year >= 0 ? year : year - 399) / 400;
+            const auto year_of_era = year - era * 400;
+            const auto day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+            return era * 146097 + day_of_era - 719468;
+        }
+
+        inline int64_t daysInMonth(int64_t year, int64_t month)
+        {
+            static constexpr int64_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+            return month == 2 && leap ? 29 : days[month - 1];
+        }
+    }
+
+    inline bool parseInt64(std::string_view value, int64_t & result)
+    {
+        const auto * pos = value.data();
+        const auto * end = pos + value.size();
+
+        const bool negative = pos != end && *pos == '-';
+
+        if (pos != end && (*pos == '-' || *pos == '+'))
+        {
+            ++pos;
+        }
+
+        uint64_t magnitude;
+        size_t number_of_digits;
+        pos = detail::parseDigits(pos, end, magnitude, number_of_digits);
+
+        if (pos != end || number_of_digits == 0 || number_of_digits > 19)
+        {
+            return false;
+        }
+
+        constexpr auto max = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+        if (magnitude > max + negative)
+        {
+            return false;
+        }
+
+        result = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+
+    inline bool parseDouble(std::string_view value, double & result)
+    {
+        const auto * pos = value.data();
+        const auto * end = pos + value.size();
+
+        // `std::from_chars` rejects a leading plus, but not a sign after it
+        if (pos != end && *pos == '+')
+        {
+            if (++pos != end && *pos == '-')
+            {
+                return false;
+            }
+        }
+
+        const auto [ptr, error] = std::from_chars(pos, end, result);
+
+        return pos != end && error == std::errc() && ptr == end;
+    }
+
+    inline bool parseBool(std::string_view value, bool & result)
+    {
+        if (value == "1" || detail::equalsIgnoreCase(value, "true") || detail::equalsIgnoreCase(value, "yes"))
+        {
+            result = true;
+            return true;
+        }
+
+        if (value == "0" || detail::equalsIgnoreCase(value, "false") || detail::equalsIgnoreCase(value, "no"))
+        {
+            result = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    inline bool parseTimestamp(std::string_view value, int64_t & microseconds)
+    {
+        static constexpr int64_t MICROSECONDS_PER_SECOND = 1'000'000;
+
+        const auto * pos = value.data();
+        const auto * end = pos + value.size();
+
+        // Seconds since the epoch: no date separator after the first four digits
+        if (value.size() < 5 || value[4] != '-')
+        {
+            const bool negative = pos != end && *pos == '-';
+
+            if (negative)
+            {
+                ++pos;
+            }
+
+            uint64_t seconds;
+            size_t number_of_digits;
+            pos = detail::parseDigits(pos, end, seconds, number_of_digits);
+
+            if (number_of_digits == 0 || number_of_digits > 12)
+            {
+                return false;
+            }
+
+            int64_t fraction = 0;
+
+            if (pos != end && *pos == '.' && !detail::parseMicroseconds(++pos, end, fraction))
+            {
+                return false;
+            }
+
+            if (pos != end)
+            {
+                return false;
+            }
+
+            const auto magnitude = static_cast<int64_t>(seconds) * MICROSECONDS_PER_SECOND + fraction;
+            microseconds = negative ? -magnitude : magnitude;
+            return true;
+        }
+
+        int64_t year;
+        int64_t month;
+        int64_t day;
+
+        if (!detail::parseFixedDigits(pos, end, 4, year) || *pos++ != '-'
+            || !detail::parseFixedDigits(pos, end, 2, month) || pos == end || *pos++ != '-'
+            || !detail::parseFixedDigits(pos, end, 2, day))
+        {
+            return false;
+        }
+
+        if (month < 1 || month > 12 || day < 1 || day > detail::daysInMonth(year, month))
+        {
+            return false;
+        }
+
+        int64_t hour = 0;
+        int64_t minute = 0;
+        int64_t second = 0;
+        int64_t fraction = 0;
+        int64_t offset_minutes = 0;
+
+        if (pos != end)
+        {
+            if (*pos != 'T' && *pos != ' ')
+            {
+                return false;
+            }
+
+            ++pos;
+
+            if (!detail::parseFixedDigits(pos, end, 2, hour) || pos == end || *pos++ != ':'
+                || !detail::parseFixedDigits(pos, end, 2, minute) || pos == end || *pos++ != ':'
+                || !detail::parseFixedDigits(pos, end, 2, second))
+            {
+                return false;
+            }
+
+            if (hour > 23 || minute > 59 || second > 59)
+            {
+                return false;
+            }
+
+            if (pos != end && (*pos == '.' || *pos == ',') && !detail::parseMicroseconds(++pos, end, fraction))
+            {
+                return false;
+            }
+
+            if (pos != end && *pos == 'Z')
+            {
+                ++pos;
+            }
+            else if (pos != end && (*pos == '+' || *pos == '-'))
+            {
+                const int64_t sign = *pos++ == '-' ? -1 : 1;
+                int64_t offset_hours;
+                int64_t offset_remaining_minutes;
+
+                if (!detail::parseFixedDigits(pos, end, 2, offset_hours))
+                {
+                    return false;
+                }
+
+                if (pos != end && *pos == ':')
+                {
+                    ++pos;
+                }
+
+                if (!detail::parseFixedDigits(pos, end, 2, offset_remaining_minutes) || offset_hours > 23 || offset_remaining_minutes > 59)
+                {
+                    return false;
+                }
+
+                offset_minutes = sign * (offset_hours * 60 + offset_remaining_minutes);
+            }
+
+            if (pos != end)
+            {
+                return false;
+            }
+        }
+
+        const auto seconds = detail::daysFromCivil(year, month, day) * 86400 + hour * 3600 + (minute - offset_minutes) * 60 + second;
+        microseconds = seconds * MICROSECONDS_PER_SECOND + fraction;
+        return true;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace extractKV
+{
+    /*
+     * Arrow `Utf8` array: 32 bit offsets into one data buffer, and a validity bitmap. See `ColumnarBatch`.
+     * */
+    struct Utf8Column
+    {
+        /// One more than the number of values, value `i` is `data[offsets[i], offsets[i + 1])`.
+        std::vector<int32_t> offsets {0};
+        std::string data;
+
+        /// One bit per value, least significant bit first, unset for nulls. Not maintained for columns without nulls, like the keys and
+        /// values of the map layout or dictionaries.
+        std::vector<uint8_t> validity;
+        size_t null_count = 0;
+
+        size_t size() const
+        {
+            return offsets.size() - 1u;
+        }
+
+        std::string_view value(size_t index) const
+        {
+            return std::string_view(data).substr(offsets[index], offsets[index + 1] - offsets[index]);
+        }
+
+        bool isNull(size_t index) const
+        {
+            return null_count && !(validity[index / 8] & (1u << (index % 8)));
+        }
+    };
+}
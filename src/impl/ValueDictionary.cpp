@@ -0,0 +1,109 @@
+#include <impl/ValueDictionary.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <util/KeyHash.h>
+
+namespace extractKV
+{
+    namespace
+    {
+        constexpr size_t INITIAL_SLOTS = 64;
+    }
+
+    ValueDictionary::ValueDictionary()
+        : slots(INITIAL_SLOTS)
+    {
+    }
+
+    uint32_t ValueDictionary::insert(std::string_view value)
+    {
+        const auto hash = KeyHash::hash(value);
+        const auto slot_mask = slots.size() - 1u;
+
+        for (auto slot = hash & slot_mask;; slot = (slot + 1) & slot_mask)
+        {
+            auto & [slot_hash, index] = slots[slot];
+
+            if (index == EMPTY)
+            {
+                if (values.data.size() + value.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) [[unlikely]]
+                {
+                    throw std::runtime_error ("Dictionary data exceeds 2 GiB");
+                }
+
+                slot_hash = hash;
+                index = static_cast<uint32_t>(values.size());
+
+                values.data.append(value);
+                values.offsets.push_back(static_cast<int32_t>(values.data.size()));
+
+                const auto inserted = index;
+
+                if (values.size() * 2 > slots.size())
+                {
+                    grow();
+                }
+
+                return inserted;
+            }
+
+            if (slot_hash == hash && values.value(index) == value)
+            {
+                return index;
+            }
+        }
+    }
+
+    bool ValueDictionary::contains(std::string_view value) const
+    {
+        const auto hash = KeyHash::hash(value);
+        const auto slot_mask = slots.size() - 1u;
+
+        for (auto slot = hash & slot_mask;; slot = (slot + 1) & slot_mask)
+        {
+            const auto & [slot_hash, index] = slots[slot];
+
+            if (index == EMPTY)
+            {
+                return false;
+            }
+
+            if (slot_hash == hash && values.value(index) == value)
+            {
+                return true;
+            }
+        }
+    }
+
+    void ValueDictionary::grow()
+    {
+        std::vector<Slot> grown(slots.size() * 2);
+        const auto slot_mask = grown.size() - 1u;
+
+        for (const auto & entry : slots)
+        {
+            if (entry.index != EMPTY)
+            {
+                auto slot = entry.hash & slot_mask;
+
+                while (grown[slot].index != EMPTY)
+                {
+                    slot = (slot + 1) & slot_mask;
+                }
+
+                grown[slot] = entry;
+            }
+        }
+
+        slots.swap(grown);
+    }
+
+    void ValueDictionary::clear()
+    {
+        values.offsets.resize(1);
+        values.data.clear();
+        std::fill(slots.begin(), slots.end(), Slot());
+    }
+}
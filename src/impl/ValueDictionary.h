@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <impl/Utf8Column.h>
+
+namespace extractKV
+{
+    /*
+     * Distinct values of a low cardinality column and their dense indices, the dictionary of Arrow's dictionary encoding, see
+     * `ColumnarBatch`. Values are stored once in a `Utf8Column` and found through an open addressing table of (hash, index) slots,
+     * kept at a load factor of at most 0.5 like `KeyDictionary`, but single threaded and growing.
+     * */
+    class ValueDictionary
+    {
+    public:
+        ValueDictionary();
+
+        /// Index of `value`, which is added if it is new.
+        uint32_t insert(std::string_view value);
+
+        bool contains(std::string_view value) const;
+
+        size_t size() const
+        {
+            return values.size();
+        }
+
+        const Utf8Column & getValues() const
+        {
+            return values;
+        }
+
+        void clear();
+
+    private:
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        struct Slot
+        {
+            uint64_t hash = 0;
+            uint32_t index = EMPTY;
+        };
+
+        void grow();
+
+        Utf8Column values;
+        std::vector<Slot> slots;
+    };
+}
@@ -0,0 +1,397 @@
+#include <impl/serializer/ArrowStreamWriter.h>
+
+#include <stdexcept>
+
+namespace extractKV
+{
+    namespace
+    {
+        using Offset = FlatBufferBuilder::Offset;
+
+        /// Field ids and enum values of the Arrow FlatBuffers schema, Schema.fbs and Message.fbs. A union takes two ids, type and value.
+        namespace fbs
+        {
+            constexpr int16_t METADATA_VERSION_V5 = 4;
+
+            constexpr uint8_t MESSAGE_HEADER_SCHEMA = 1;
+            constexpr uint8_t MESSAGE_HEADER_DICTIONARY_BATCH = 2;
+            constexpr uint8_t MESSAGE_HEADER_RECORD_BATCH = 3;
+
+            constexpr uint8_t TYPE_INT = 2;
+            constexpr uint8_t TYPE_FLOATING_POINT = 3;
+            constexpr uint8_t TYPE_UTF8 = 5;
+            constexpr uint8_t TYPE_BOOL = 6;
+            constexpr uint8_t TYPE_TIMESTAMP = 10;
+            constexpr uint8_t TYPE_STRUCT = 13;
+
+            constexpr int16_t PRECISION_DOUBLE = 2;
+            constexpr int16_t TIME_UNIT_MICROSECOND = 2;
+            constexpr uint8_t TYPE_MAP = 17;
+
+            namespace Message { enum : uint16_t { VERSION, HEADER_TYPE, HEADER, BODY_LENGTH }; }
+            namespace Schema { enum : uint16_t { ENDIANNESS, FIELDS }; }
+            namespace Field { enum : uint16_t { NAME, NULLABLE, TYPE_TYPE, TYPE, DICTIONARY, CHILDREN }; }
+            namespace Map { enum : uint16_t { KEYS_SORTED }; }
+            namespace Int { enum : uint16_t { BIT_WIDTH, IS_SIGNED }; }
+            namespace FloatingPoint { enum : uint16_t { PRECISION }; }
+            namespace Timestamp { enum : uint16_t { UNIT, TIMEZONE }; }
+            namespace DictionaryEncoding { enum : uint16_t { ID, INDEX_TYPE, IS_ORDERED }; }
+            namespace RecordBatch { enum : uint16_t { LENGTH, NODES, BUFFERS }; }
+            namespace DictionaryBatch { enum : uint16_t { ID, DATA, IS_DELTA }; }
+        }
+
+        constexpr uint32_t CONTINUATION = 0xFFFFFFFF;
+        constexpr size_t ALIGNMENT = 8;
+
+        size_t padding(size_t size)
+        {
+            return (ALIGNMENT - size % ALIGNMENT) % ALIGNMENT;
+        }
+
+        Offset createEmptyTable(FlatBufferBuilder & builder)
+        {
+            builder.startTable();
+            return builder.endTable();
+        }
+
+        /// `dictionary` is a `DictionaryEncoding` table, or 0 for columns without dictionary encoding.
+        Offset createField(FlatBufferBuilder & builder, std::string_view name, bool nullable, uint8_t type_type, Offset type,
+                           const std::vector<Offset> & children, Offset dictionary = 0)
+        {
+            const auto name_offset = builder.createString(name);
+            // Readers reject fields without a children vector, even an empty one
+            const auto children_offset = builder.createVectorOfOffsets(children);
+
+            builder.startTable();
+            builder.addOffsetField(fbs::Field::NAME, name_offset);
+            builder.addField(fbs::Field::NULLABLE, nullable);
+            builder.addField(fbs::Field::TYPE_TYPE, type_type);
+            builder.addOffsetField(fbs::Field::TYPE, type);
+
+            if (dictionary)
+            {
+                builder.addOffsetField(fbs::Field::DICTIONARY, dictionary);
+            }
+
+            builder.addOffsetField(fbs::Field::CHILDREN, children_offset);
+
+            return builder.endTable();
+        }
+
+        Offset createUtf8Field(FlatBufferBuilder & builder, std::string_view name, bool nullable)
+        {
+            return createField(builder, name, nullable, fbs::TYPE_UTF8, createEmptyTable(builder), {});
+        }
+
+        /// A `Utf8` column whose indices into dictionary `id` are unsigned integers of `bit_width` bits.
+        Offset createDictionaryField(FlatBufferBuilder & builder, std::string_view name, int64_t id, int32_t bit_width)
+        {
+            builder.startTable();
+            builder.addField(fbs::Int::BIT_WIDTH, bit_width);
+            builder.addField(fbs::Int::IS_SIGNED, false);
+            const auto index_type = builder.endTable();
+
+            builder.startTable();
+            builder.addField(fbs::DictionaryEncoding::ID, id);
+            builder.addOffsetField(fbs::DictionaryEncoding::INDEX_TYPE, index_type);
+            builder.addField(fbs::DictionaryEncoding::IS_ORDERED, false);
+            const auto dictionary = builder.endTable();
+
+            return createField(builder, name, true, fbs::TYPE_UTF8, createEmptyTable(builder), {}, dictionary);
+        }
+
+        /// `Int64`, `Float64`, `Bool` or `Timestamp(MICROSECOND, UTC)`, see `TypedColumn`.
+        Offset createTypedField(FlatBufferBuilder & builder, std::string_view name, ValueType type)
+        {
+            switch (type)
+            {
+                case ValueType::INT64:
+                {
+                    builder.startTable();
+                    builder.addField(fbs::Int::BIT_WIDTH, int32_t {64});
+                    builder.addField(fbs::Int::IS_SIGNED, true);
+                    return createField(builder, name, true, fbs::TYPE_INT, builder.endTable(), {});
+                }
+                case ValueType::DOUBLE:
+                {
+                    builder.startTable();
+                    builder.addField(fbs::FloatingPoint::PRECISION, fbs::PRECISION_DOUBLE);
+                    return createField(builder, name, true, fbs::TYPE_FLOATING_POINT, builder.endTable(), {});
+                }
+                case ValueType::BOOL:
+                    return createField(builder, name, true, fbs::TYPE_BOOL, createEmptyTable(builder), {});
+                case ValueType::TIMESTAMP:
+                {
+                    const auto timezone = builder.createString("UTC");
+
+                    builder.startTable();
+                    builder.addField(fbs::Timestamp::UNIT, fbs::TIME_UNIT_MICROSECOND);
+                    builder.addOffsetField(fbs::Timestamp::TIMEZONE, timezone);
+                    return createField(builder, name, true, fbs::TYPE_TIMESTAMP, builder.endTable(), {});
+                }
+                case ValueType::STRING:
+                    break;
+            }
+
+            return createUtf8Field(builder, name, true);
+        }
+
+        Offset createMapField(FlatBufferBuilder & builder)
+        {
+            const auto key = createUtf8Field(builder, "key", false);
+            const auto value = createUtf8Field(builder, "value", false);
+            const auto entries = createField(builder, "entries", false, fbs::TYPE_STRUCT, createEmptyTable(builder), {key, value});
+
+            builder.startTable();
+            builder.addField(fbs::Map::KEYS_SORTED, false);
+            const auto map_type = builder.endTable();
+
+            return createField(builder, "pairs", false, fbs::TYPE_MAP, map_type, {entries});
+        }
+    }
+
+    ArrowStreamWriter::ArrowStreamWriter(WriteBuffer & out_)
+        : out(out_)
+    {
+    }
+
+    void ArrowStreamWriter::write(const ColumnarBatch & batch)
+    {
+        writeSchema(batch);
+
+        if (!batch.isMap())
+        {
+            for (size_t i = 0; i < batch.getColumnNames().size(); ++i)
+            {
+                if (batch.getEncoding(i) != encodings[i] || batch.getType(i) != types[i])
+                {
+                    throw std::runtime_error ("Type or encoding of column '" + batch.getColumnNames()[i]
+                                              + "' differ from the schema of the stream");
+                }
+
+                if (encodings[i] != ColumnarBatch::Encoding::PLAIN)
+                {
+                    writeDictionaryBatch(static_cast<int64_t>(i), batch.getDictionaryColumn(i).dictionary.getValues());
+                }
+            }
+        }
+
+        nodes.clear();
+        body.clear();
+
+        if (batch.isMap())
+        {
+            const auto & map_offsets = batch.getMapOffsets();
+            const auto number_of_entries = static_cast<int64_t>(batch.getKeys().size());
+
+            // Map: validity and offsets, then the entries struct: validity, then its key and value children
+            nodes.push_back({static_cast<int64_t>(batch.numberOfRows()), 0});
+            addBuffer(nullptr, 0);
+            addBuffer(map_offsets.data(), map_offsets.size() * sizeof(int32_t));
+
+            nodes.push_back({number_of_entries, 0});
+            addBuffer(nullptr, 0);
+
+            addUtf8Column(batch.getKeys());
+            addUtf8Column(batch.getValues());
+        }
+        else
+        {
+            for (size_t i = 0; i < batch.getColumnNames().size(); ++i)
+            {
+                if (types[i] != ValueType::STRING)
+                {
+                    addTypedColumn(batch.getTypedColumn(i));
+                }
+                else if (encodings[i] == ColumnarBatch::Encoding::PLAIN)
+                {
+                    addUtf8Column(batch.getColumn(i));
+                }
+                else
+                {
+                    addDictionaryColumn(batch.getDictionaryColumn(i), batch.numberOfRows());
+                }
+            }
+        }
+
+        builder.clear();
+
+        int64_t body_length;
+        const auto record_batch = createRecordBatch(static_cast<int64_t>(batch.numberOfRows()), body_length);
+
+        writeMessage(fbs::MESSAGE_HEADER_RECORD_BATCH, record_batch, body_length);
+        writeBody();
+    }
+
+    void ArrowStreamWriter::writeDictionaryBatch(int64_t id, const ColumnarBatch::Utf8Column & dictionary)
+    {
+        nodes.clear();
+        body.clear();
+
+        addUtf8Column(dictionary);
+
+        builder.clear();
+
+        int64_t body_length;
+        const auto record_batch = createRecordBatch(static_cast<int64_t>(dictionary.size()), body_length);
+
+        // Each batch has its own dictionary, which replaces the one of the previous batch
+        builder.startTable();
+        builder.addField(fbs::DictionaryBatch::ID, id);
+        builder.addOffsetField(fbs::DictionaryBatch::DATA, record_batch);
+        builder.addField(fbs::DictionaryBatch::IS_DELTA, false);
+        const auto dictionary_batch = builder.endTable();
+
+        writeMessage(fbs::MESSAGE_HEADER_DICTIONARY_BATCH, dictionary_batch, body_length);
+        writeBody();
+    }
+
+    FlatBufferBuilder::Offset ArrowStreamWriter::createRecordBatch(int64_t length, int64_t & body_length)
+    {
+        std::vector<BufferRegion> regions;
+        body_length = 0;
+
+        for (const auto & buffer : body)
+        {
+            regions.push_back({body_length, static_cast<int64_t>(buffer.size)});
+            body_length += static_cast<int64_t>(buffer.size + padding(buffer.size));
+        }
+
+        const auto nodes_offset = builder.createVector(nodes.data(), nodes.size());
+        const auto buffers_offset = builder.createVector(regions.data(), regions.size());
+
+        builder.startTable();
+        builder.addField(fbs::RecordBatch::LENGTH, length);
+        builder.addOffsetField(fbs::RecordBatch::NODES, nodes_offset);
+        builder.addOffsetField(fbs::RecordBatch::BUFFERS, buffers_offset);
+
+        return builder.endTable();
+    }
+
+    void ArrowStreamWriter::writeBody()
+    {
+        static constexpr char zeros[ALIGNMENT] = {};
+
+        for (const auto & buffer : body)
+        {
+            out.write(static_cast<const char *>(buffer.data), buffer.size);
+            out.write(zeros, padding(buffer.size));
+        }
+    }
+
+    void ArrowStreamWriter::finish(const ColumnarBatch & batch)
+    {
+        writeSchema(batch);
+
+        out.write(reinterpret_cast<const char *>(&CONTINUATION), sizeof(CONTINUATION));
+        out.write(std::string_view("\0\0\0\0", 4));
+    }
+
+    void ArrowStreamWriter::writeSchema(const ColumnarBatch & batch)
+    {
+        if (schema_written)
+        {
+            return;
+        }
+
+        builder.clear();
+
+        std::vector<Offset> fields;
+
+        if (batch.isMap())
+        {
+            fields.push_back(createMapField(builder));
+        }
+        else
+        {
+            const auto & names = batch.getColumnNames();
+
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                encodings.push_back(batch.getEncoding(i));
+                types.push_back(batch.getType(i));
+
+                if (types.back() != ValueType::STRING)
+                {
+                    fields.push_back(createTypedField(builder, names[i], types.back()));
+                    continue;
+                }
+
+                switch (encodings.back())
+                {
+                    case ColumnarBatch::Encoding::PLAIN:
+                        fields.push_back(createUtf8Field(builder, names[i], true));
+                        break;
+                    case ColumnarBatch::Encoding::DICTIONARY_UINT8:
+                        fields.push_back(createDictionaryField(builder, names[i], static_cast<int64_t>(i), 8));
+                        break;
+                    case ColumnarBatch::Encoding::DICTIONARY_UINT16:
+                        fields.push_back(createDictionaryField(builder, names[i], static_cast<int64_t>(i), 16));
+                        break;
+                }
+            }
+        }
+
+        const auto fields_offset = builder.createVectorOfOffsets(fields);
+
+        builder.startTable();
+        builder.addField(fbs::Schema::ENDIANNESS, int16_t {0});
+        builder.addOffsetField(fbs::Schema::FIELDS, fields_offset);
+        const auto schema = builder.endTable();
+
+        writeMessage(fbs::MESSAGE_HEADER_SCHEMA, schema, 0);
+
+        schema_written = true;
+    }
+
+    void ArrowStreamWriter::addUtf8Column(const ColumnarBatch::Utf8Column & column)
+    {
+        nodes.push_back({static_cast<int64_t>(column.size()), static_cast<int64_t>(column.null_count)});
+
+        // Without nulls the validity bitmap may be omitted
+        addBuffer(column.validity.data(), column.null_count ? (column.size() + 7) / 8 : 0);
+        addBuffer(column.offsets.data(), column.offsets.size() * sizeof(int32_t));
+        addBuffer(column.data.data(), column.data.size());
+    }
+
+    void ArrowStreamWriter::addDictionaryColumn(const ColumnarBatch::DictionaryColumn & column, size_t number_of_rows)
+    {
+        nodes.push_back({static_cast<int64_t>(number_of_rows), static_cast<int64_t>(column.null_count)});
+
+        addBuffer(column.validity.data(), column.null_count ? (number_of_rows + 7) / 8 : 0);
+        addBuffer(column.indices.data(), column.indices.size());
+    }
+
+    void ArrowStreamWriter::addTypedColumn(const TypedColumn & column)
+    {
+        nodes.push_back({static_cast<int64_t>(column.size()), static_cast<int64_t>(column.null_count)});
+
+        addBuffer(column.validity.data(), column.null_count ? (column.size() + 7) / 8 : 0);
+        addBuffer(column.data.data(), column.data.size());
+    }
+
+    void ArrowStreamWriter::addBuffer(const void * data, size_t size)
+    {
+        body.push_back({data, size});
+    }
+
+    void ArrowStreamWriter::writeMessage(uint8_t header_type, Offset header, int64_t body_length)
+    {
+        builder.startTable();
+        builder.addField(fbs::Message::VERSION, fbs::METADATA_VERSION_V5);
+        builder.addField(fbs::Message::HEADER_TYPE, header_type);
+        builder.addOffsetField(fbs::Message::HEADER, header);
+        builder.addField(fbs::Message::BODY_LENGTH, body_length);
+        const auto metadata = builder.finish(builder.endTable());
+
+        // The continuation marker and the length keep the metadata 8 byte aligned, its padding keeps the body aligned
+        const auto metadata_length = static_cast<int32_t>(metadata.size() + padding(metadata.size()));
+
+        static constexpr char zeros[ALIGNMENT] = {};
+
+        out.write(reinterpret_cast<const char *>(&CONTINUATION), sizeof(CONTINUATION));
+        out.write(reinterpret_cast<const char *>(&metadata_length), sizeof(metadata_length));
+        out.write(metadata);
+        out.write(zeros, padding(metadata.size()));
+    }
+}
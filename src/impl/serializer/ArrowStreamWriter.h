@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <impl/ColumnarBatch.h>
+#include <impl/serializer/FlatBufferBuilder.h>
+#include <util/WriteBuffer.h>
+
+namespace extractKV
+{
+    /*
+     * Writes `ColumnarBatch`es as an Arrow IPC stream (https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format): a
+     * schema message, one record batch message per batch and the end of stream marker, readable zero copy by Arrow implementations,
+     * DuckDB or Polars. Only the IPC format is implemented, the metadata is encoded with `FlatBufferBuilder` instead of depending on
+     * Arrow or FlatBuffers.
+     *
+     * The map layout is a non nullable `pairs: Map<Utf8, Utf8>` column, the projected layout has one nullable `Utf8` column per key.
+     * The schema is taken from the first batch, all batches must have the same layout, columns and encodings. The column buffers are
+     * written to `out` as they are, padded to 8 bytes, without compression.
+     *
+     * Dictionary encoded columns are `Utf8` fields with unsigned 8 or 16 bit indices, the dictionary id is the column index. Every record
+     * batch is preceded by a dictionary batch per such column that replaces its previous dictionary. Typed columns are `Int64`,
+     * `Float64`, `Bool` or `Timestamp(MICROSECOND, UTC)` fields.
+     * */
+    class ArrowStreamWriter
+    {
+    public:
+        explicit ArrowStreamWriter(WriteBuffer & out_);
+
+        /// Writes the schema before the first batch.
+        void write(const ColumnarBatch & batch);
+
+        /// Writes the end of stream marker, and the schema if no batch was written.
+        void finish(const ColumnarBatch & batch);
+
+    private:
+        /// FlatBuffers structs `FieldNode` and `Buffer` of the `RecordBatch` message.
+        struct FieldNode
+        {
+            int64_t length;
+            int64_t null_count;
+        };
+
+        struct BufferRegion
+        {
+            int64_t offset;
+            int64_t length;
+        };
+
+        struct BodyBuffer
+        {
+            const void * data;
+            size_t size;
+        };
+
+        void writeSchema(const ColumnarBatch & batch);
+
+        void writeDictionaryBatch(int64_t id, const ColumnarBatch::Utf8Column & dictionary);
+
+        /// `RecordBatch` table of `nodes` and `body`.
+        FlatBufferBuilder::Offset createRecordBatch(int64_t length, int64_t & body_length);
+
+        void writeBody();
+
+        void addUtf8Column(const ColumnarBatch::Utf8Column & column);
+
+        void addDictionaryColumn(const ColumnarBatch::DictionaryColumn & column, size_t number_of_rows);
+
+        void addTypedColumn(const TypedColumn & column);
+
+        void addBuffer(const void * data, size_t size);
+
+        void writeMessage(uint8_t header_type, FlatBufferBuilder::Offset header, int64_t body_length);
+
+        WriteBuffer & out;
+        FlatBufferBuilder builder;
+        bool schema_written = false;
+
+        /// Encodings and types of the columns in the schema, projected layout only.
+        std::vector<ColumnarBatch::Encoding> encodings;
+        std::vector<ValueType> types;
+
+        std::vector<FieldNode> nodes;
+        std::vector<BodyBuffer> body;
+    };
+}
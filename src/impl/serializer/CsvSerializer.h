@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <impl/ColumnProjection.h>
+#include <util/WriteBuffer.h>
+#include <util/find_symbols.h>
+
+namespace extractKV
+{
+    /*
+     * Writes rows as RFC 4180 CSV with a header line and one field per column, see `ColumnProjection`. A field is quoted only if it
+     * contains the delimiter, a quote or a line break, which `find_first_symbols` checks 16 bytes at a time, quotes inside it are doubled.
+     * */
+    class CsvSerializer
+    {
+    public:
+        explicit CsvSerializer(std::vector<std::string> columns, char delimiter_ = ',')
+            : projection(std::move(columns)), delimiter(delimiter_), needs_quoting(std::string {delimiter_, '"', '\n', '\r'})
+        {
+        }
+
+        void writeHeader(WriteBuffer & out) const
+        {
+            writeFields(projection.getColumns(), out);
+        }
+
+        template <typename Map>
+        void writeRow(const Map & row, WriteBuffer & out)
+        {
+            writeFields(projection.project(row), out);
+        }
+
+        void writeField(std::string_view field, WriteBuffer & out) const
+        {
+            if (findNeedsQuoting(field) == field.data() + field.size())
+            {
+                out.write(field);
+                return;
+            }
+
+            out.write('"');
+
+            const char * pos = field.data();
+            const char * end = pos + field.size();
+
+            while (true)
+            {
+                const char * quote = find_first_symbols<'"'>(pos, end);
+                out.write(pos, quote - pos);
+
+                if (quote == end)
+                {
+                    break;
+                }
+
+                out.write("\"\"");
+                pos = quote + 1;
+            }
+
+            out.write('"');
+        }
+
+    private:
+        const char * findNeedsQuoting(std::string_view field) const
+        {
+            const char * begin = field.data();
+            const char * end = begin + field.size();
+
+            // The usual delimiters get compile time symbols, which search faster than the runtime `SearchSymbols`
+            switch (delimiter)
+            {
+                case ',': return find_first_symbols<',', '"', '\n', '\r'>(begin, end);
+                case ';': return find_first_symbols<';', '"', '\n', '\r'>(begin, end);
+                case '|': return find_first_symbols<'|', '"', '\n', '\r'>(begin, end);
+                case '\t': return find_first_symbols<'\t', '"', '\n', '\r'>(begin, end);
+                default: return find_first_symbols(field, needs_quoting);
+            }
+        }
+
+        template <typename Fields>
+        void writeFields(const Fields & fields, WriteBuffer & out) const
+        {
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                if (i)
+                {
+                    out.write(delimiter);
+                }
+
+                writeField(fields[i], out);
+            }
+
+            out.write('\n');
+        }
+
+        ColumnProjection projection;
+        const char delimiter;
+        const SearchSymbols needs_quoting;
+    };
+}
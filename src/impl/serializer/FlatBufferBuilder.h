@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace extractKV
+{
+    /*
+     * Minimal FlatBuffers builder, just enough for the Arrow IPC metadata written by `ArrowStreamWriter`: tables with scalar and
+     * offset fields, strings, and vectors of offsets or of structs. Like the reference implementation it builds the buffer back to
+     * front, so children are created before their parents, and an `Offset` is the distance of an object from the end of the buffer,
+     * which doesn't change as the buffer grows. vtables are not deduplicated, all fields are written even if equal to their default.
+     *
+     * The builder can be reused for the next buffer after `clear()`, keeping its memory.
+     * */
+    class FlatBufferBuilder
+    {
+    public:
+        static_assert(std::endian::native == std::endian::little, "FlatBuffers are little endian");
+
+        using Offset = uint32_t;
+
+        void clear()
+        {
+            size = 0;
+            min_align = 1;
+            fields.clear();
+        }
+
+        Offset createString(std::string_view s)
+        {
+            align(sizeof(uint32_t), s.size() + 1u);
+            pad(1);
+
+            if (!s.empty())
+            {
+                memcpy(reserve(s.size()), s.data(), s.size());
+            }
+
+            push(static_cast<uint32_t>(s.size()));
+
+            return static_cast<Offset>(size);
+        }
+
+        /// Vector of structs (or scalars), `T` must have the memory layout of the FlatBuffers struct.
+        template <typename T>
+        Offset createVector(const T * elements, size_t count)
+        {
+            align(std::max(sizeof(uint32_t), alignof(T)), sizeof(T) * count);
+
+            if (count)
+            {
+                memcpy(reserve(sizeof(T) * count), elements, sizeof(T) * count);
+            }
+
+            push(static_cast<uint32_t>(count));
+
+            return static_cast<Offset>(size);
+        }
+
+        Offset createVectorOfOffsets(const std::vector<Offset> & offsets)
+        {
+            align(sizeof(uint32_t), sizeof(uint32_t) * offsets.size());
+
+            for (auto it = offsets.rbegin(); it != offsets.rend(); ++it)
+            {
+                pushOffset(*it);
+            }
+
+            push(static_cast<uint32_t>(offsets.size()));
+
+            return static_cast<Offset>(size);
+        }
+
+        void startTable()
+        {
+            fields.clear();
+            table_start = size;
+        }
+
+        template <typename T>
+        void addField(uint16_t slot, T value)
+        {
+            push(value);
+            fields.push_back({slot, size});
+        }
+
+        void addOffsetField(uint16_t slot, Offset target)
+        {
+            pushOffset(target);
+            fields.push_back({slot, size});
+        }
+
+        Offset endTable()
+        {
+            // Offset to the vtable, patched once the vtable is written
+            push(int32_t {0});
+            const size_t table = size;
+
+            uint16_t number_of_slots = 0;
+
+            for (const auto & field : fields)
+            {
+                number_of_slots = std::max<uint16_t>(number_of_slots, field.slot + 1u);
+            }
+
+            // vtable: its size, the inline size of the table, then the offset of each field from the start of the table (0 if absent)
+            for (int slot = number_of_slots - 1; slot >= 0; --slot)
+            {
+                const auto field = std::find_if(fields.begin(), fields.end(), [slot](const auto & f) { return f.slot == slot; });
+                push(static_cast<uint16_t>(field == fields.end() ? 0 : table - field->position));
+            }
+
+            push(static_cast<uint16_t>(table - table_start));
+            push(static_cast<uint16_t>(sizeof(uint16_t) * (2u + number_of_slots)));
+
+            const auto vtable_offset = static_cast<int32_t>(size - table);
+            memcpy(at(table), &vtable_offset, sizeof(vtable_offset));
+
+            return static_cast<Offset>(table);
+        }
+
+        /// The finished buffer, valid until the builder is modified.
+        std::string_view finish(Offset root)
+        {
+            align(min_align, sizeof(uint32_t));
+            pushOffset(root);
+
+            return {reinterpret_cast<const char *>(at(size)), size};
+        }
+
+    private:
+        struct Field
+        {
+            uint16_t slot;
+            size_t position;
+        };
+
+        uint8_t * at(size_t position)
+        {
+            return buffer.data() + buffer.size() - position;
+        }
+
+        /// Prepends `n` bytes, returns their address.
+        uint8_t * reserve(size_t n)
+        {
+            if (size + n > buffer.size())
+            {
+                std::vector<uint8_t> grown(std::max(buffer.size() * 2, size + n + 1024u));
+
+                // The buffer is still unallocated before the first bytes, passing its null data to `memcpy` is undefined
+                if (size)
+                {
+                    memcpy(grown.data() + grown.size() - size, at(size), size);
+                }
+
+                buffer.swap(grown);
+            }
+
+            size += n;
+
+            return at(size);
+        }
+
+        void pad(size_t n)
+        {
+            if (n == 0)
+            {
+                return;
+            }
+
+            memset(reserve(n), 0, n);
+        }
+
+        /// Pads so that the buffer is aligned to `alignment` after prepending `extra` more bytes.
+        void align(size_t alignment, size_t extra = 0)
+        {
+            min_align = std::max(min_align, alignment);
+            pad((alignment - (size + extra) % alignment) % alignment);
+        }
+
+        template <typename T>
+        void push(T value)
+        {
+            align(sizeof(T));
+            memcpy(reserve(sizeof(T)), &value, sizeof(T));
+        }
+
+        void pushOffset(Offset target)
+        {
+            align(sizeof(uint32_t));
+            push(static_cast<uint32_t>(size + sizeof(uint32_t) - target));
+        }
+
+        std::vector<uint8_t> buffer;
+        size_t size = 0;
+        size_t min_align = 1;
+
+        size_t table_start = 0;
+        std::vector<Field> fields;
+    };
+}
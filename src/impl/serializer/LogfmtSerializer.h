@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string_view>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <util/WriteBuffer.h>
+#include <util/find_symbols.h>
+
+namespace extractKV
+{
+    /*
+     * Writes rows as logfmt, `key=value` pairs separated by spaces, one line per row. Keys and values that are empty or contain a
+     * space, `=`, a quote, a backslash or a control character are quoted and escaped like JSON strings, the rest is written as is.
+     * */
+    class LogfmtSerializer
+    {
+    public:
+        /// logfmt has no header.
+        static void writeHeader(WriteBuffer &) {}
+
+        template <typename Map>
+        static void writeRow(const Map & row, WriteBuffer & out)
+        {
+            bool first = true;
+
+            for (const auto & [key, value] : row)
+            {
+                if (!first)
+                {
+                    out.write(' ');
+                }
+
+                first = false;
+
+                writeString(key, out);
+                out.write('=');
+                writeString(value, out);
+            }
+
+            out.write('\n');
+        }
+
+        static void writeString(std::string_view s, WriteBuffer & out)
+        {
+            if (!s.empty() && find_first_symbols_or_control<' ', '=', '"', '\\'>(s.data(), s.data() + s.size()) == s.data() + s.size())
+            {
+                out.write(s);
+                return;
+            }
+
+            NdjsonSerializer::writeString(s, out);
+        }
+    };
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <util/WriteBuffer.h>
+#include <util/find_symbols.h>
+
+namespace extractKV
+{
+    /*
+     * Writes rows as newline delimited JSON, one object per row with the pairs in the map's iteration order. Keys and values are JSON
+     * strings: quotes, backslashes and control characters are escaped, other bytes are copied as is, so the output is valid JSON as long
+     * as the input is UTF-8. The next byte to escape is found with `find_first_symbols_or_control`, 16 bytes at a time, and the run
+     * before it is copied with a single `write`.
+     * */
+    class NdjsonSerializer
+    {
+    public:
+        /// NDJSON has no header.
+        static void writeHeader(WriteBuffer &) {}
+
+        template <typename Map>
+        static void writeRow(const Map & row, WriteBuffer & out)
+        {
+            out.write('{');
+
+            bool first = true;
+
+            for (const auto & [key, value] : row)
+            {
+                if (!first)
+                {
+                    out.write(',');
+                }
+
+                first = false;
+
+                writeString(key, out);
+                out.write(':');
+                writeString(value, out);
+            }
+
+            out.write('}');
+            out.write('\n');
+        }
+
+        static void writeString(std::string_view s, WriteBuffer & out)
+        {
+            out.write('"');
+            writeEscaped(s, out);
+            out.write('"');
+        }
+
+        /// The contents of a JSON string, without the quotes.
+        static void writeEscaped(std::string_view s, WriteBuffer & out)
+        {
+            const char * pos = s.data();
+            const char * end = pos + s.size();
+
+            while (true)
+            {
+                const char * next = find_first_symbols_or_control<'"', '\\'>(pos, end);
+                out.write(pos, next - pos);
+
+                if (next == end)
+                {
+                    return;
+                }
+
+                const auto byte = static_cast<unsigned char>(*next);
+                const char escape = ESCAPES[byte];
+
+                out.write('\\');
+                out.write(escape);
+
+                if (escape == 'u')
+                {
+                    out.write("00");
+                    out.write(HEX_DIGITS[byte >> 4]);
+                    out.write(HEX_DIGITS[byte & 0xF]);
+                }
+
+                pos = next + 1;
+            }
+        }
+
+    private:
+        static constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+
+        /// The character following the backslash for the bytes found by `find_first_symbols_or_control<'"', '\\'>`.
+        static constexpr std::array<char, 256> ESCAPES = []
+        {
+            std::array<char, 256> escapes {};
+
+            for (size_t c = 0; c < 0x20; ++c)
+            {
+                escapes[c] = 'u';
+            }
+
+            escapes['"'] = '"';
+            escapes['\\'] = '\\';
+            escapes['\b'] = 'b';
+            escapes['\f'] = 'f';
+            escapes['\n'] = 'n';
+            escapes['\r'] = 'r';
+            escapes['\t'] = 't';
+
+            return escapes;
+        }();
+    };
+}
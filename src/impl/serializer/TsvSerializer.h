@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <impl/ColumnProjection.h>
+#include <util/WriteBuffer.h>
+#include <util/find_symbols.h>
+
+namespace extractKV
+{
+    /*
+     * Writes rows as tab separated values with a header line and one field per column, see `ColumnProjection`. Fields are not quoted,
+     * tabs, line breaks and backslashes are escaped with a backslash instead (`\t`, `\n`, `\r`, `\\`), like most TSV readers expect.
+     * */
+    class TsvSerializer
+    {
+    public:
+        explicit TsvSerializer(std::vector<std::string> columns)
+            : projection(std::move(columns))
+        {
+        }
+
+        void writeHeader(WriteBuffer & out) const
+        {
+            writeFields(projection.getColumns(), out);
+        }
+
+        template <typename Map>
+        void writeRow(const Map & row, WriteBuffer & out)
+        {
+            writeFields(projection.project(row), out);
+        }
+
+        static void writeField(std::string_view field, WriteBuffer & out)
+        {
+            const char * pos = field.data();
+            const char * end = pos + field.size();
+
+            while (true)
+            {
+                const char * next = find_first_symbols<'\t', '\n', '\r', '\\'>(pos, end);
+                out.write(pos, next - pos);
+
+                if (next == end)
+                {
+                    return;
+                }
+
+                out.write('\\');
+
+                switch (*next)
+                {
+                    case '\t': out.write('t'); break;
+                    case '\n': out.write('n'); break;
+                    case '\r': out.write('r'); break;
+                    default: out.write('\\'); break;
+                }
+
+                pos = next + 1;
+            }
+        }
+
+    private:
+        template <typename Fields>
+        static void writeFields(const Fields & fields, WriteBuffer & out)
+        {
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                if (i)
+                {
+                    out.write('\t');
+                }
+
+                writeField(fields[i], out);
+            }
+
+            out.write('\n');
+        }
+
+        ColumnProjection projection;
+    };
+}
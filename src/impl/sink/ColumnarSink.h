@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <impl/ColumnarBatch.h>
+
+namespace extractKV
+{
+    /*
+     * Appends the row to a `ColumnarBatch`. Pairs go straight into the column buffers as they are flushed, `finish` commits the row
+     * unless it was dropped by the row filter or stopped by an error, e.g. an exceeded limit. Key hashes, used to find duplicated keys and columns, are computed by the extractor
+     * while reading the keys.
+     * */
+    class ColumnarSink
+    {
+    public:
+        static constexpr bool needs_key_hash = true;
+
+        explicit ColumnarSink(ColumnarBatch & batch_)
+            : batch(batch_)
+        {}
+
+        void onPair(std::string_view key, uint64_t key_hash, std::string_view value)
+        {
+            batch.addPair(key, key_hash, value);
+        }
+
+        void discard()
+        {
+            batch.discardRow();
+            discarded = true;
+        }
+
+        void onError()
+        {
+            discard();
+        }
+
+        void finish()
+        {
+            if (!discarded)
+            {
+                batch.commitRow();
+            }
+        }
+
+    private:
+        ColumnarBatch & batch;
+        bool discarded = false;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <impl/Diagnostics.h>
+
+namespace extractKV
+{
+    /*
+     * Forwards pairs to another sink and records the tokens dropped by the state handler into `Diagnostics` (`reports_discards`).
+     * Extractions without diagnostics don't use this sink, so they don't pay for the reporting at all.
+     * */
+    template <typename Sink>
+    class DiagnosticsSink
+    {
+    public:
+        static constexpr bool needs_key_hash = []
+        {
+            if constexpr (requires { Sink::needs_key_hash; })
+            {
+                return Sink::needs_key_hash;
+            }
+
+            return false;
+        }();
+
+        static constexpr bool reports_discards = true;
+
+        DiagnosticsSink(Diagnostics & diagnostics_, std::string_view row_data_, Sink & sink_)
+            : diagnostics(diagnostics_), row_data(row_data_), sink(sink_)
+        {
+            diagnostics.beginRow();
+        }
+
+        auto onPair(std::string_view key, std::string_view value)
+        {
+            return sink.onPair(key, value);
+        }
+
+        auto onPair(std::string_view key, uint64_t key_hash, std::string_view value)
+        {
+            return sink.onPair(key, key_hash, value);
+        }
+
+        void onDiscard(Diagnostics::Discard reason, size_t begin, size_t end)
+        {
+            diagnostics.record(reason, begin, end, row_data);
+        }
+
+        void discard()
+        {
+            sink.discard();
+        }
+
+        void finish()
+        {
+            sink.finish();
+        }
+
+        std::pmr::memory_resource * memoryResource() const
+        requires requires (const Sink & s) { s.memoryResource(); }
+        {
+            return sink.memoryResource();
+        }
+
+    private:
+        Diagnostics & diagnostics;
+        std::string_view row_data;
+        Sink & sink;
+    };
+}
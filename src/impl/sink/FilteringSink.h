@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+#include <impl/RowFilter.h>
+
+namespace extractKV
+{
+    /*
+     * Evaluates a `RowFilter` on the pairs flushed to another sink. `onPair` returns false once a predicate failed, which makes the
+     * extractor stop right away, and the pairs already forwarded are discarded. Otherwise pairs are forwarded as they come. Each
+     * predicate is decided by the first occurrence of its key, see `RowFilter`.
+     *
+     * Sinks with a boolean `onPair` can abandon the row this way. Sinks that can be filtered implement `discard()`, which drops the
+     * pairs received so far.
+     * */
+    template <typename Sink>
+    class FilteringSink
+    {
+    public:
+        static constexpr bool needs_key_hash = []
+        {
+            if constexpr (requires { Sink::needs_key_hash; })
+            {
+                return Sink::needs_key_hash;
+            }
+
+            return false;
+        }();
+
+        static constexpr bool reports_discards = []
+        {
+            if constexpr (requires { Sink::reports_discards; })
+            {
+                return Sink::reports_discards;
+            }
+
+            return false;
+        }();
+
+        FilteringSink(const RowFilter & filter_, Sink & sink_)
+            : predicates(filter_.getPredicates()), sink(sink_)
+        {}
+
+        bool onPair(std::string_view key, std::string_view value)
+        {
+            if (!accepts(key, value))
+            {
+                return false;
+            }
+
+            sink.onPair(key, value);
+            return true;
+        }
+
+        bool onPair(std::string_view key, uint64_t key_hash, std::string_view value)
+        {
+            if (!accepts(key, value))
+            {
+                return false;
+            }
+
+            sink.onPair(key, key_hash, value);
+            return true;
+        }
+
+        void onDiscard(auto reason, size_t begin, size_t end) requires reports_discards
+        {
+            sink.onDiscard(reason, begin, end);
+        }
+
+        void onError() requires requires (Sink & s) { s.onError(); }
+        {
+            sink.onError();
+        }
+
+        void finish()
+        {
+            for (size_t i = 0; i < predicates.size() && kept; ++i)
+            {
+                if (!(decided & (1ull << i)) && !predicates[i].acceptsMissingKey())
+                {
+                    kept = false;
+                }
+            }
+
+            if (!kept)
+            {
+                sink.discard();
+            }
+
+            sink.finish();
+        }
+
+        std::pmr::memory_resource * memoryResource() const
+        requires requires (const Sink & s) { s.memoryResource(); }
+        {
+            return sink.memoryResource();
+        }
+
+        /// Whether the row passed the filter, valid after `finish`.
+        bool isKept() const
+        {
+            return kept;
+        }
+
+    private:
+        bool accepts(std::string_view key, std::string_view value)
+        {
+            for (size_t i = 0; i < predicates.size(); ++i)
+            {
+                const auto mask = 1ull << i;
+
+                if (!(decided & mask) && predicates[i].key == key)
+                {
+                    decided |= mask;
+
+                    if (!predicates[i].acceptsValue(value))
+                    {
+                        kept = false;
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        const std::vector<RowFilter::Predicate> & predicates;
+        Sink & sink;
+
+        uint64_t decided = 0;
+        bool kept = true;
+    };
+}
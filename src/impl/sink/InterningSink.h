@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <KeyValuePairExtractor.h>
+#include <impl/KeyDictionary.h>
+#include <impl/sink/ResponseSink.h>
+
+namespace extractKV
+{
+    /*
+     * Stores pairs in a `KeyValuePairExtractor::InternedResponse`, replacing each key with its id in `KeyDictionary`. Value strings
+     * already present in the response, or set aside in its `spare_values` by a shorter row, are assigned into, so their capacity is
+     * reused across rows. Key hashes are computed by the
+     * extractor while reading the keys.
+     * */
+    class InterningSink
+    {
+    public:
+        using InternedResponse = KeyValuePairExtractor::InternedResponse;
+
+        InterningSink(KeyDictionary & dictionary_, InternedResponse & response_)
+            : dictionary(dictionary_), response(response_), overflow_sink(response_.overflow)
+        {}
+
+        static constexpr bool needs_key_hash = true;
+
+        void onPair(std::string_view key, uint64_t key_hash, std::string_view value)
+        {
+            const auto id = dictionary.intern(key, key_hash);
+
+            if (id == KeyDictionary::INVALID_ID)
+            {
+                overflow_sink.onPair(key, value);
+                return;
+            }
+
+            auto & pairs = response.pairs;
+
+            // Cheap filter for duplicated keys: only scan the pairs if an id with the same low bits was already seen in this row.
+            const uint64_t id_bit = 1ull << (id & 63u);
+
+            if (seen_ids & id_bit)
+            {
+                for (size_t i = 0; i < number_of_pairs; ++i)
+                {
+                    if (pairs[i].first == id)
+                    {
+                        pairs[i].second.assign(value);
+                        return;
+                    }
+                }
+            }
+
+            seen_ids |= id_bit;
+
+            if (number_of_pairs < pairs.size())
+            {
+                pairs[number_of_pairs].first = id;
+                pairs[number_of_pairs].second.assign(value);
+            }
+            else if (auto & spare_values = response.spare_values; !spare_values.empty())
+            {
+                spare_values.back().assign(value);
+                pairs.emplace_back(id, std::move(spare_values.back()));
+                spare_values.pop_back();
+            }
+            else
+            {
+                pairs.emplace_back(id, value);
+            }
+
+            ++number_of_pairs;
+        }
+
+        void discard()
+        {
+            number_of_pairs = 0;
+            overflow_sink.discard();
+        }
+
+        void finish()
+        {
+            auto & pairs = response.pairs;
+
+            for (size_t i = number_of_pairs; i < pairs.size(); ++i)
+            {
+                response.spare_values.push_back(std::move(pairs[i].second));
+            }
+
+            pairs.resize(number_of_pairs);
+            overflow_sink.finish();
+        }
+
+    private:
+        KeyDictionary & dictionary;
+        InternedResponse & response;
+        ResponseSink<KeyValuePairExtractor::Response> overflow_sink;
+
+        size_t number_of_pairs = 0;
+        uint64_t seen_ids = 0;
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace extractKV
+{
+    /*
+     * Receives the pairs flushed by `CHKeyValuePairExtractor` and stores them in a caller owned map, last value wins.
+     *
+     * Sinks implement `onPair(key, value)`, called for every flushed pair, and `finish()`, called once the whole row was processed. The
+     * views passed to `onPair` are only valid for the duration of the call. Sinks declaring `static constexpr bool needs_key_hash = true`
+     * get `onPair(key, key_hash, value)` instead, with `key_hash == KeyHash::hash(key)`.
+     *
+     * The map is refilled in place: its nodes are detached when the sink is created and reused for the new pairs, assigning into the
+     * existing key and value strings. For rows with the same shape as the previous one that means no node and no string allocation, and
+     * the bucket array is kept as well. Nodes left over at the end are released together with the sink.
+     *
+     * With a `std::pmr` map, new keys and values allocate from the resource of the map, and so do the buffers of the escaping
+     * `StringWriter` (`memoryResource()`), so a whole extraction can be served from a caller's arena.
+     * */
+    template <typename Map>
+    class ResponseSink
+    {
+    public:
+        explicit ResponseSink(Map & response_)
+            : response(response_)
+        {
+            spare_nodes.reserve(response.size());
+
+            while (!response.empty())
+            {
+                spare_nodes.push_back({response.extract(response.begin())});
+            }
+        }
+
+        ResponseSink(const ResponseSink &) = delete;
+
+        void onPair(std::string_view key, std::string_view value)
+        {
+            if (spare_nodes.empty())
+            {
+                auto [position, _] = response.try_emplace(typename Map::key_type(key, StringAllocator(response.get_allocator())));
+                position->second.assign(value);
+                return;
+            }
+
+            auto node = std::move(spare_nodes.back().node);
+            spare_nodes.pop_back();
+
+            node.key().assign(key);
+            node.mapped().assign(value);
+
+            auto result = response.insert(std::move(node));
+
+            if (!result.inserted)
+            {
+                // Duplicated key, keep the latest value and give the node back.
+                result.position->second.swap(result.node.mapped());
+                spare_nodes.push_back({std::move(result.node)});
+            }
+        }
+
+        void discard()
+        {
+            response.clear();
+        }
+
+        std::pmr::memory_resource * memoryResource() const
+        requires std::is_same_v<typename Map::allocator_type, std::pmr::polymorphic_allocator<typename Map::value_type>>
+        {
+            return response.get_allocator().resource();
+        }
+
+        void finish() {}
+
+    private:
+        using StringAllocator = typename Map::key_type::allocator_type;
+
+        // Enough for the nodes of a typical row without touching the heap.
+        static constexpr auto SPARE_NODES_BUFFER_SIZE = 1024u;
+
+        Map & response;
+
+        std::array<std::byte, SPARE_NODES_BUFFER_SIZE> spare_nodes_buffer;
+        std::pmr::monotonic_buffer_resource spare_nodes_resource {spare_nodes_buffer.data(), spare_nodes_buffer.size()};
+        // Wrapped, as node handles of `std::pmr` maps advertise an allocator the vector would try to construct them with.
+        struct SpareNode
+        {
+            typename Map::node_type node;
+        };
+
+        std::pmr::vector<SpareNode> spare_nodes {&spare_nodes_resource};
+    };
+}
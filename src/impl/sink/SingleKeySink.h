@@ -0,0 +1,33 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace extractKV
+{
+    /*
+     * Keeps the value of the last pair with the given key and drops everything else, see `KeyValuePairExtractor::extractValue`.
+     * */
+    class SingleKeySink
+    {
+    public:
+        SingleKeySink(std::string_view key_, std::optional<std::string> & value_)
+            : key(key_), value(value_)
+        {}
+
+        void onPair(std::string_view pair_key, std::string_view pair_value)
+        {
+            if (pair_key == key)
+            {
+                value.emplace(pair_value);
+            }
+        }
+
+        void finish() {}
+
+    private:
+        std::string_view key;
+        std::optional<std::string> & value;
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <KeyValuePairExtractor.h>
+#include <impl/NullStringWriter.h>
+
+namespace extractKV
+{
+    /*
+     * Counts pairs and collects malformed regions into a `KeyValuePairExtractor::ValidationResult`. Keys and values are never
+     * materialized: the extractor runs with `NullStringWriter`s (`StringWriter`), and reports the tokens dropped by the state handler
+     * through `onDiscard` (`reports_discards`).
+     * */
+    class ValidatingSink
+    {
+    public:
+        using StringWriter = NullStringWriter;
+        using ValidationResult = KeyValuePairExtractor::ValidationResult;
+
+        static constexpr bool reports_discards = true;
+
+        explicit ValidatingSink(ValidationResult & result_)
+            : result(result_)
+        {
+            result.number_of_pairs = 0;
+            result.malformed_regions.clear();
+        }
+
+        void onPair(std::string_view /* key */, std::string_view /* value */)
+        {
+            ++result.number_of_pairs;
+        }
+
+        void onDiscard(ValidationResult::Discard reason, size_t begin, size_t end)
+        {
+            result.malformed_regions.push_back({begin, end, reason});
+        }
+
+        void finish() {}
+
+    private:
+        ValidationResult & result;
+    };
+}
@@ -2,9 +2,38 @@
 
 /*
  * Handle state transitions and a few states like `FLUSH_PAIR` and `END`.
+ *
+ * All methods are const: per extraction state (writers, search statistics, pair counter) lives on the stack, and the state handler
+ * with its needles is immutable after construction. One instance can be shared across threads.
+ *
+ * The state machine itself never throws on bad input: errors, e.g. exceeded `Limits`, are reported through `RunResult`. `tryExtract`
+ * returns them as values, the other public methods turn them into exceptions.
  * */
+#include <chrono>
+#include <concepts>
+#include <expected>
+#include <memory_resource>
+#include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include "KeyValuePairExtractor.h"
+#include <impl/AdaptiveSymbolSearch.h>
+#include <impl/Diagnostics.h>
+#include <impl/HashingStringWriter.h>
+#include <impl/LatencyHistogram.h>
+#include <impl/LimitedStringWriter.h>
+#include <impl/Limits.h>
+#include <impl/RowFilter.h>
+#include <impl/RowShape.h>
+#include <impl/sink/ColumnarSink.h>
+#include <impl/sink/DiagnosticsSink.h>
+#include <impl/sink/ResponseSink.h>
+#include <impl/sink/FilteringSink.h>
+#include <impl/sink/InterningSink.h>
+#include <impl/sink/SingleKeySink.h>
+#include <impl/sink/ValidatingSink.h>
+#include <util/Probes.h>
+#include <util/find_substring.h>
 
 template <typename StateHandler>
 class CHKeyValuePairExtractor : public KeyValuePairExtractor
@@ -13,43 +42,216 @@ class CHKeyValuePairExtractor : public KeyValuePairExtractor
     using NextState = StateHandler::NextState;
 
 public:
-    explicit CHKeyValuePairExtractor(StateHandler state_handler_, uint64_t max_number_of_pairs_)
-            : state_handler(std::move(state_handler_)), max_number_of_pairs(max_number_of_pairs_)
+    explicit CHKeyValuePairExtractor(StateHandler state_handler_, extractKV::Limits limits_,
+                                     std::shared_ptr<extractKV::KeyDictionary> key_dictionary_ = nullptr,
+                                     std::shared_ptr<const extractKV::RowFilter> row_filter_ = nullptr,
+                                     std::shared_ptr<extractKV::LatencyHistogram> latency_histogram_ = nullptr)
+            : state_handler(std::move(state_handler_)), limits(limits_), key_dictionary(std::move(key_dictionary_)),
+            row_filter(std::move(row_filter_)), latency_histogram(std::move(latency_histogram_))
     {}
 
-    Response extract(const std::string & file) override
+    Response extract(const std::string & file) const override
     {
         return extract(std::string_view {file});
     }
 
-    Response extract(std::string_view data)
+    Response extract(std::string_view data) const
     {
-        auto state =  State::WAITING_KEY;
-
         Response response;
 
-        auto key_writer = typename StateHandler::StringWriter();
-        auto value_writer = typename StateHandler::StringWriter();
+        extract(data, response);
 
-        uint64_t row_offset = 0;
+        return response;
+    }
 
-        while (state != State::END)
+    /*
+     * Replaces the contents of `response` with the pairs found in `data`. Nodes, strings and buckets of `response` are reused, see
+     * `ResponseSink`.
+     * */
+    bool extract(std::string_view data, Response & response) const override
+    {
+        extractKV::ResponseSink sink(response);
+        NoRowShape shape;
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
+
+    bool extract(std::string_view data, Response & response, extractKV::Diagnostics & diagnostics) const override
+    {
+        extractKV::ResponseSink response_sink(response);
+        extractKV::DiagnosticsSink sink(diagnostics, data, response_sink);
+        NoRowShape shape;
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
+
+    std::expected<bool, ExtractionError> tryExtract(std::string_view data, Response & response) const override
+    {
+        extractKV::ResponseSink sink(response);
+        NoRowShape shape;
+
+        return expected(runFiltered(data, sink, shape));
+    }
+
+    std::expected<bool, ExtractionError> tryExtract(std::string_view data, PmrResponse & response) const override
+    {
+        extractKV::ResponseSink sink(response);
+        NoRowShape shape;
+
+        return expected(runFiltered(data, sink, shape));
+    }
+
+    std::expected<bool, ExtractionError> tryExtract(std::string_view data, Response & response,
+                                                    extractKV::Diagnostics & diagnostics) const override
+    {
+        extractKV::ResponseSink response_sink(response);
+        extractKV::DiagnosticsSink sink(diagnostics, data, response_sink);
+        NoRowShape shape;
+
+        return expected(runFiltered(data, sink, shape));
+    }
+
+    std::expected<bool, ExtractionError> tryExtract(std::string_view data, extractKV::ColumnarBatch & batch) const override
+    {
+        extractKV::ColumnarSink sink(batch);
+        NoRowShape shape;
+
+        return expected(runFiltered(data, sink, shape));
+    }
+
+    std::expected<bool, ExtractionError> tryExtract(std::string_view data, Response & response, extractKV::RowShape & row_shape) const
+    {
+        extractKV::ResponseSink sink(response);
+        RowShapeTracker shape(row_shape);
+
+        return expected(runFiltered(data, sink, shape));
+    }
+
+    /*
+     * Message of the exception the throwing methods raise for `error`.
+     * */
+    std::string describe(const ExtractionError & error) const
+    {
+        using Code = ExtractionError::Code;
+
+        switch (error.code)
+        {
+            case Code::PAST_END_OF_DATA: return "Attempt to move read pointer past end of available data";
+            case Code::KEY_LENGTH_LIMIT: return limits.describe(extractKV::Limits::Kind::KEY_LENGTH);
+            case Code::VALUE_LENGTH_LIMIT: return limits.describe(extractKV::Limits::Kind::VALUE_LENGTH);
+            case Code::OUTPUT_BYTES_LIMIT: return limits.describe(extractKV::Limits::Kind::OUTPUT_BYTES);
+            case Code::NUMBER_OF_PAIRS_LIMIT: return limits.describe(extractKV::Limits::Kind::NUMBER_OF_PAIRS);
+        }
+
+        return std::string(ExtractionError::toString(error.code));
+    }
+
+    /*
+     * Same as above, checking the keys against the key sequence of the previous row first, see `RowShape`. `row_shape` must only be
+     * used with extractors of the same configuration.
+     * */
+    bool extract(std::string_view data, Response & response, extractKV::RowShape & row_shape) const
+    {
+        extractKV::ResponseSink sink(response);
+        RowShapeTracker shape(row_shape);
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
+
+    bool extract(std::string_view data, PmrResponse & response) const override
+    {
+        extractKV::ResponseSink sink(response);
+        NoRowShape shape;
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
+
+    bool extract(std::string_view data, InternedResponse & response) const override
+    {
+        if (!key_dictionary)
         {
-            auto next_state = processState(data, state, key_writer, value_writer, row_offset, response);
+            throw std::runtime_error ("Key dictionary is not configured, see KeyValuePairExtractorBuilder::withKeyDictionary");
+        }
+
+        extractKV::InterningSink sink(*key_dictionary, response);
+        NoRowShape shape;
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
+
+    bool extract(std::string_view data, extractKV::ColumnarBatch & batch) const override
+    {
+        extractKV::ColumnarSink sink(batch);
+        NoRowShape shape;
+
+        return checked(runFiltered(data, sink, shape)).kept;
+    }
 
-            if (next_state.position_in_string > data.size() && next_state.state != State::END)
+    void validate(std::string_view data, ValidationResult & result) const override
+    {
+        extractKV::ValidatingSink sink(result);
+        NoRowShape shape;
+
+        checked(run(data, sink, shape));
+    }
+
+    /*
+     * Looks for `key` followed by the key value delimiter with a SIMD substring search and parses the pairs of the occurrences that
+     * start a key, instead of tokenizing the whole input.
+     *
+     * This is exact up to the first quoting or escape character, past which the state machine depends on the quoting state. The input
+     * after the last pair delimiter preceding that character is extracted as usual. Limits only apply to the pairs that are actually
+     * parsed, and the row filter does not apply.
+     * */
+    std::optional<std::string> extractValue(std::string_view data, std::string_view key) const override
+    {
+        std::optional<std::string> value;
+        extractKV::SingleKeySink sink(key, value);
+        NoRowShape shape;
+
+        if (!state_handler.isPlainKey(key))
+        {
+            // Quoted or escaped keys only
+            checked(run(data, sink, shape));
+            return value;
+        }
+
+        const auto unquoted_length = state_handler.unquotedPrefixLength(data);
+
+        const size_t searchable_length = unquoted_length == data.size()
+            ? data.size()
+            : state_handler.positionAfterLastPairDelimiter(data.substr(0, unquoted_length));
+
+        std::string pattern {key};
+        pattern.push_back(state_handler.configuration.key_value_delimiter);
+
+        const char * const searchable_end = data.begin() + searchable_length;
+        const char * last_key_start = nullptr;
+
+        for (const char * candidate = data.begin();
+             (candidate = find_first_substring(candidate, searchable_end, pattern)) != searchable_end;
+             ++candidate)
+        {
+            if (state_handler.isKeyStart(data, candidate - data.begin()))
             {
-                throw std::runtime_error ("Attempt to move read pointer past end of available data");
+                last_key_start = candidate;
             }
+        }
 
-            data.remove_prefix(next_state.position_in_string);
-            state = next_state.state;
+        if (last_key_start)
+        {
+            const size_t value_begin = last_key_start + pattern.size() - data.begin();
+            const size_t value_end = value_begin + state_handler.findPairDelimiter(data.substr(value_begin, searchable_length - value_begin));
+
+            checked(run(data.substr(last_key_start - data.begin(), value_end - (last_key_start - data.begin())), sink, shape));
         }
 
-        // below reset discards invalid keys and values
-        reset(key_writer, value_writer);
+        if (searchable_length < data.size())
+        {
+            checked(run(data.substr(searchable_length), sink, shape));
+        }
 
-        return response;
+        return value;
     }
 
     extractKV::Configuration getConfiguration() const override
@@ -59,21 +261,451 @@ public:
 
 private:
 
-    NextState processState(std::string_view file, State state, auto & key, auto & value, uint64_t & row_offset, Response & response)
+    /*
+     * Outcome of running the state machine over a row.
+     * */
+    struct RunResult
+    {
+        // Whether the row passed the row filter.
+        bool kept = true;
+        uint64_t number_of_pairs = 0;
+        std::optional<ExtractionError> error;
+    };
+
+    /*
+     * Per row counters checked against `limits` when pairs are flushed, and the error that stopped the row, if any.
+     * */
+    struct RowState
+    {
+        uint64_t number_of_pairs = 0;
+        uint64_t output_bytes = 0;
+        size_t row_size = 0;
+        std::optional<ExtractionError> error;
+    };
+
+    /*
+     * Turns an error into an exception for the throwing public methods.
+     * */
+    RunResult checked(RunResult result) const
+    {
+        if (result.error) [[unlikely]]
+        {
+            throw std::runtime_error (describe(*result.error));
+        }
+
+        return result;
+    }
+
+    static std::expected<bool, ExtractionError> expected(const RunResult & result)
+    {
+        if (result.error) [[unlikely]]
+        {
+            return std::unexpected(*result.error);
+        }
+
+        return result.kept;
+    }
+
+    /*
+     * Glue between the state machine and a caller owned `RowShape`, one per extraction. `NoRowShape` is the plain `readKey` path.
+     * */
+    struct NoRowShape
+    {
+        NextState readKey(const StateHandler & handler, std::string_view file, auto & key, auto & search, uint64_t /* key_index */)
+        {
+            return handler.readKey(file, key, search);
+        }
+
+        void onPairFlushed(uint64_t /* key_index */) {}
+
+        void finish(uint64_t /* number_of_pairs */) {}
+    };
+
+    class RowShapeTracker
+    {
+    public:
+        explicit RowShapeTracker(extractKV::RowShape & shape_)
+            : shape(shape_), enabled(shape_.beginRow())
+        {}
+
+        NextState readKey(const StateHandler & handler, std::string_view file, auto & key, auto & search, uint64_t key_index)
+        {
+            if (enabled && key_index < shape.size())
+            {
+                if (const auto length = shape.match(key_index, file, handler.configuration.key_value_delimiter))
+                {
+                    key.reset();
+                    key.append(file.substr(0, length));
+
+                    pending_key = PendingKey::REMEMBERED;
+
+                    return {length + 1u, State::WAITING_VALUE};
+                }
+            }
+
+            auto next_state = handler.readKey(file, key, search);
+
+            if (next_state.state == State::WAITING_VALUE)
+            {
+                // `readKey` stops right after the key value delimiter
+                raw_key = file.substr(0, next_state.position_in_string - 1u);
+                pending_key = PendingKey::READ;
+            }
+
+            return next_state;
+        }
+
+        void onPairFlushed(uint64_t key_index)
+        {
+            if (enabled)
+            {
+                if (pending_key == PendingKey::READ)
+                {
+                    shape.remember(key_index, raw_key);
+                }
+                else if (pending_key == PendingKey::NONE)
+                {
+                    // Quoted key
+                    shape.forget(key_index);
+                }
+            }
+
+            pending_key = PendingKey::NONE;
+        }
+
+        void finish(uint64_t number_of_pairs)
+        {
+            if (enabled)
+            {
+                shape.forget(number_of_pairs);
+            }
+        }
+
+    private:
+        enum class PendingKey
+        {
+            NONE,
+            REMEMBERED,
+            READ
+        };
+
+        extractKV::RowShape & shape;
+        const bool enabled;
+
+        PendingKey pending_key = PendingKey::NONE;
+        std::string_view raw_key;
+    };
+
+    /*
+     * Sinks that declare `needs_key_hash` receive `onPair(key, key_hash, value)`, the hash being computed while the key is read.
+     * */
+    template <typename Sink>
+    static constexpr bool sinkNeedsKeyHash()
+    {
+        if constexpr (requires { Sink::needs_key_hash; })
+        {
+            return Sink::needs_key_hash;
+        }
+
+        return false;
+    }
+
+    /*
+     * Sinks may pick the `StringWriter`, e.g. `ValidatingSink` doesn't need keys and values at all.
+     * */
+    template <typename Sink>
+    struct SinkStringWriter
+    {
+        using Type = typename StateHandler::StringWriter;
+    };
+
+    template <typename Sink>
+    requires requires { typename Sink::StringWriter; }
+    struct SinkStringWriter<Sink>
+    {
+        using Type = typename Sink::StringWriter;
+    };
+
+    template <typename Sink>
+    using ValueWriter = typename SinkStringWriter<Sink>::Type;
+
+    template <typename Sink>
+    using KeyWriter = std::conditional_t<sinkNeedsKeyHash<Sink>(), extractKV::HashingStringWriter<ValueWriter<Sink>>, ValueWriter<Sink>>;
+
+    /*
+     * Writers that can allocate from a memory resource use the one of the sink, if it has one, see `ResponseSink`.
+     * */
+    template <typename Writer>
+    static Writer makeWriter(auto & sink, auto ... arguments)
+    {
+        if constexpr (requires { { sink.memoryResource() } -> std::same_as<std::pmr::memory_resource *>; }
+                      && std::is_constructible_v<Writer, decltype(arguments)..., std::pmr::memory_resource *>)
+        {
+            return Writer(arguments..., sink.memoryResource());
+        }
+        else
+        {
+            return Writer(arguments...);
+        }
+    }
+
+    /*
+     * Sinks that declare `reports_discards` get `onDiscard(reason, begin, end)` for every token dropped by the state handler. Dropped
+     * tokens also fire the `discard` probe, see `Probes.h`.
+     * */
+    template <typename Sink>
+    static constexpr bool sinkReportsDiscards()
+    {
+        if constexpr (requires { Sink::reports_discards; })
+        {
+            return Sink::reports_discards;
+        }
+
+        return false;
+    }
+
+    static void reportDiscard(auto & sink, const NextState & next_state, size_t state_begin)
+    {
+#if KVP_PROBES_ENABLED
+        if (next_state.discard != extractKV::StateHandler::Discard::NONE) [[unlikely]]
+        {
+            KVP_PROBE(discard, static_cast<int>(next_state.discard), state_begin, state_begin + next_state.position_in_string);
+        }
+#endif
+
+        if constexpr (sinkReportsDiscards<std::remove_reference_t<decltype(sink)>>())
+        {
+            if (next_state.discard != extractKV::StateHandler::Discard::NONE) [[unlikely]]
+            {
+                sink.onDiscard(next_state.discard, state_begin, state_begin + next_state.position_in_string);
+            }
+        }
+    }
+
+    /*
+     * Entry point of all `extract` variants. Records the latency of the extraction if a histogram is set.
+     * */
+    template <typename Sink>
+    RunResult runFiltered(std::string_view data, Sink & sink, auto & shape) const
+    {
+        KVP_PROBE(extract_start, data.data(), data.size());
+
+        RunResult result;
+
+        if (!latency_histogram)
+        {
+            result = runFilteredUntimed(data, sink, shape);
+        }
+        else
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            result = runFilteredUntimed(data, sink, shape);
+
+            latency_histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        KVP_PROBE(extract_end, data.size(), result.number_of_pairs, static_cast<int>(result.kept));
+
+        return result;
+    }
+
+    /*
+     * Runs the state machine through a `FilteringSink` if a row filter is set. Returns whether the row was kept.
+     * */
+    template <typename Sink>
+    RunResult runFilteredUntimed(std::string_view data, Sink & sink, auto & shape) const
+    {
+        if (!row_filter)
+        {
+            return run(data, sink, shape);
+        }
+
+        extractKV::FilteringSink filtering_sink(*row_filter, sink);
+
+        auto result = run(data, filtering_sink, shape);
+        result.kept = filtering_sink.isKept();
+
+        return result;
+    }
+
+    /*
+     * Runs the state machine over `data` and hands every pair over to `sink`, see `ResponseSink` for the interface. Writers only
+     * enforce length limits if there are any.
+     * */
+    template <typename Sink>
+    RunResult run(std::string_view data, Sink & sink, auto & shape) const
+    {
+        if (limits.limitsLengths())
+        {
+            auto key_writer = makeWriter<extractKV::LimitedStringWriter<KeyWriter<Sink>>>(sink, limits.key_length.max);
+            auto value_writer = makeWriter<extractKV::LimitedStringWriter<ValueWriter<Sink>>>(sink, limits.value_length.max);
+
+            return run(data, key_writer, value_writer, sink, shape);
+        }
+
+        auto key_writer = makeWriter<KeyWriter<Sink>>(sink);
+        auto value_writer = makeWriter<ValueWriter<Sink>>(sink);
+
+        return run(data, key_writer, value_writer, sink, shape);
+    }
+
+    RunResult run(std::string_view data, auto & key_writer, auto & value_writer, auto & sink, auto & shape) const
+    {
+        RowState row;
+        row.row_size = data.size();
+
+        KVP_PROBE(row_start, data.data(), data.size());
+
+        extractKV::AdaptiveSymbolSearch search(state_handler.byte_classes);
+
+        // `KVP_EXTRACTOR_DISABLE_COMPUTED_GOTO` forces the portable switch on GCC and Clang as well, so that its tests run there
+#if defined(__GNUC__) && !defined(KVP_EXTRACTOR_DISABLE_COMPUTED_GOTO)
+        runWithComputedGoto(data, key_writer, value_writer, search, shape, row, sink);
+#else
+        runWithSwitch(data, key_writer, value_writer, search, shape, row, sink);
+#endif
+
+        shape.finish(row.number_of_pairs);
+
+        // below reset discards invalid keys and values
+        reset(key_writer, value_writer);
+
+        // Sinks that commit whole rows, like `ColumnarSink`, drop a row that failed instead of committing part of it
+        if constexpr (requires { sink.onError(); })
+        {
+            if (row.error)
+            {
+                sink.onError();
+            }
+        }
+
+        sink.finish();
+
+        KVP_PROBE(row_end, data.size(), row.number_of_pairs, row.error ? static_cast<int>(row.error->code) + 1 : 0);
+
+        return {true, row.number_of_pairs, row.error};
+    }
+
+#if defined(__GNUC__) && !defined(KVP_EXTRACTOR_DISABLE_COMPUTED_GOTO)
+    /*
+     * Each state jumps straight to the handler of the next state through a computed goto. Every state has its own indirect jump,
+     * which the branch predictor learns much better than the single jump of a `switch` inside a loop, and the cursor stays in a local
+     * pointer instead of being re-sliced on every transition.
+     * */
+    void runWithComputedGoto(std::string_view data, auto & key, auto & value, auto & search, auto & shape, RowState & row, auto & sink) const
+    {
+        static_assert(State::WAITING_KEY == 0 && State::READING_KEY == 1 && State::READING_QUOTED_KEY == 2
+                      && State::READING_KV_DELIMITER == 3 && State::WAITING_VALUE == 4 && State::READING_VALUE == 5
+                      && State::READING_QUOTED_VALUE == 6 && State::FLUSH_PAIR == 7 && State::END == 8,
+                      "Computed goto table must follow the order of StateHandler::State");
+
+        static const void * const handlers[] = {
+                &&waiting_key, &&reading_key, &&reading_quoted_key, &&reading_kv_delimiter,
+                &&waiting_value, &&reading_value, &&reading_quoted_value, &&flush_pair, &&end
+        };
+
+        const char * pos = data.begin();
+        const char * const data_end = data.end();
+
+        NextState next_state;
+
+#define KVP_DISPATCH_NEXT_STATE() \
+        do \
+        { \
+            if (next_state.position_in_string > static_cast<size_t>(data_end - pos)) [[unlikely]] \
+            { \
+                if (next_state.state != State::END) \
+                    row.error = ExtractionError {ExtractionError::Code::PAST_END_OF_DATA, static_cast<size_t>(pos - data.begin())}; \
+                next_state = {static_cast<size_t>(data_end - pos), State::END}; \
+            } \
+            reportDiscard(sink, next_state, pos - data.begin()); \
+            pos += next_state.position_in_string; \
+            goto *handlers[next_state.state]; \
+        } while (false)
+
+    waiting_key:
+        next_state = state_handler.waitKey({pos, data_end}, search);
+        KVP_DISPATCH_NEXT_STATE();
+
+    reading_key:
+        next_state = shape.readKey(state_handler, {pos, data_end}, key, search, row.number_of_pairs);
+        KVP_DISPATCH_NEXT_STATE();
+
+    reading_quoted_key:
+        next_state = state_handler.readQuotedKey({pos, data_end}, key, search);
+        KVP_DISPATCH_NEXT_STATE();
+
+    reading_kv_delimiter:
+        next_state = state_handler.readKeyValueDelimiter({pos, data_end});
+        KVP_DISPATCH_NEXT_STATE();
+
+    waiting_value:
+        next_state = state_handler.waitValue({pos, data_end});
+        KVP_DISPATCH_NEXT_STATE();
+
+    reading_value:
+        next_state = state_handler.readValue({pos, data_end}, value, search);
+        KVP_DISPATCH_NEXT_STATE();
+
+    reading_quoted_value:
+        next_state = state_handler.readQuotedValue({pos, data_end}, value, search);
+        KVP_DISPATCH_NEXT_STATE();
+
+    flush_pair:
+        next_state = flushPair({pos, data_end}, key, value, shape, row, sink);
+        KVP_DISPATCH_NEXT_STATE();
+
+    end:
+        return;
+
+#undef KVP_DISPATCH_NEXT_STATE
+    }
+#endif
+
+    void runWithSwitch(std::string_view data, auto & key, auto & value, auto & search, auto & shape, RowState & row, auto & sink) const
+    {
+        auto state = State::WAITING_KEY;
+        size_t state_begin = 0;
+
+        while (state != State::END)
+        {
+            auto next_state = processState(data, state, key, value, search, shape, row, sink);
+
+            if (next_state.position_in_string > data.size())
+            {
+                if (next_state.state != State::END)
+                {
+                    row.error = ExtractionError {ExtractionError::Code::PAST_END_OF_DATA, state_begin};
+                }
+
+                next_state = {data.size(), State::END};
+            }
+
+            reportDiscard(sink, next_state, state_begin);
+
+            data.remove_prefix(next_state.position_in_string);
+            state_begin += next_state.position_in_string;
+            state = next_state.state;
+        }
+    }
+
+    NextState processState(std::string_view file, State state, auto & key, auto & value, auto & search, auto & shape,
+                           RowState & row, auto & sink) const
     {
         switch (state)
         {
             case State::WAITING_KEY:
             {
-                return state_handler.waitKey(file);
+                return state_handler.waitKey(file, search);
             }
             case State::READING_KEY:
             {
-                return state_handler.readKey(file, key);
+                return shape.readKey(state_handler, file, key, search, row.number_of_pairs);
             }
             case State::READING_QUOTED_KEY:
             {
-                return state_handler.readQuotedKey(file, key);
+                return state_handler.readQuotedKey(file, key, search);
             }
             case State::READING_KV_DELIMITER:
             {
@@ -85,15 +717,15 @@ private:
             }
             case State::READING_VALUE:
             {
-                return state_handler.readValue(file, value);
+                return state_handler.readValue(file, value, search);
             }
             case State::READING_QUOTED_VALUE:
             {
-                return state_handler.readQuotedValue(file, value);
+                return state_handler.readQuotedValue(file, value, search);
             }
             case State::FLUSH_PAIR:
             {
-                return flushPair(file, key, value, row_offset, response);
+                return flushPair(file, key, value, shape, row, sink);
             }
             case State::END:
             {
@@ -103,26 +735,127 @@ private:
     }
 
     NextState flushPair(const std::string_view & file, auto & key,
-                        auto & value, uint64_t & row_offset, Response & response)
+                        auto & value, auto & shape, RowState & row, auto & sink) const
+    {
+        using Kind = extractKV::Limits::Kind;
+
+        const NextState next_state {0, file.empty() ? State::END : State::WAITING_KEY};
+
+        if (row.number_of_pairs >= limits.number_of_pairs.max) [[unlikely]]
+        {
+            return exceedLimit(Kind::NUMBER_OF_PAIRS, file, row, next_state);
+        }
+
+        if constexpr (requires { key.exceededLimit(); })
+        {
+            if (key.exceededLimit() && limits.key_length.policy != extractKV::Limits::Policy::TRUNCATE)
+            {
+                return exceedLimit(Kind::KEY_LENGTH, file, row, next_state);
+            }
+
+            if (value.exceededLimit() && limits.value_length.policy != extractKV::Limits::Policy::TRUNCATE)
+            {
+                return exceedLimit(Kind::VALUE_LENGTH, file, row, next_state);
+            }
+        }
+
+        uint64_t key_hash = 0;
+
+        if constexpr (sinkNeedsKeyHash<std::remove_reference_t<decltype(sink)>>())
+        {
+            key_hash = key.hash();
+        }
+
+        const auto committed_key = key.commit();
+        const auto committed_value = value.commit();
+
+        if (limits.output_bytes.isSet()) [[unlikely]]
+        {
+            const auto pair_bytes = committed_key.size() + committed_value.size();
+
+            if (pair_bytes > limits.output_bytes.max - row.output_bytes)
+            {
+                return exceedLimit(Kind::OUTPUT_BYTES, file, row, next_state);
+            }
+
+            row.output_bytes += pair_bytes;
+        }
+
+        KVP_PROBE(pair_flush, row.row_size - file.size(), committed_key.size(), committed_value.size());
+
+        shape.onPairFlushed(row.number_of_pairs);
+
+        row.number_of_pairs++;
+
+        bool keep_going = true;
+
+        if constexpr (sinkNeedsKeyHash<std::remove_reference_t<decltype(sink)>>())
+        {
+            keep_going = onPair(sink, committed_key, key_hash, committed_value);
+        }
+        else
+        {
+            keep_going = onPair(sink, committed_key, committed_value);
+        }
+
+        if (!keep_going)
+        {
+            // The sink abandoned the row
+            return {0, State::END};
+        }
+
+        return next_state;
+    }
+
+    /*
+     * Applies the policy of the exceeded limit to the pair being flushed. `next_state` is where extraction goes on if it does.
+     * */
+    NextState exceedLimit(extractKV::Limits::Kind kind, std::string_view file, RowState & row, NextState next_state) const
     {
-        row_offset++;
+        using Policy = extractKV::Limits::Policy;
+
+        const auto policy = limits.get(kind).policy;
+
+        KVP_PROBE(limit_hit, static_cast<int>(kind), static_cast<int>(policy), row.row_size - file.size());
 
-        if (row_offset > max_number_of_pairs)
+        if (policy == Policy::SKIP_PAIR && kind != extractKV::Limits::Kind::NUMBER_OF_PAIRS)
         {
-            throw std::runtime_error ("Number of pairs produced exceeded the limit of " + std::to_string(max_number_of_pairs));
+            return next_state;
         }
 
-        response[std::string(key.commit())] = std::string(value.commit());
+        if (policy == Policy::ERROR)
+        {
+            row.error = ExtractionError {ExtractionError::fromLimit(kind), row.row_size - file.size()};
+        }
 
-        return {0, file.empty() ? State::END : State::WAITING_KEY};
+        return {0, State::END};
+    }
+
+    /*
+     * Sinks may return false from `onPair` to abandon the row, see `FilteringSink`.
+     * */
+    static bool onPair(auto & sink, auto && ... arguments)
+    {
+        if constexpr (std::is_same_v<decltype(sink.onPair(arguments...)), bool>)
+        {
+            return sink.onPair(arguments...);
+        }
+        else
+        {
+            sink.onPair(arguments...);
+            return true;
+        }
     }
 
-    void reset(auto & key, auto & value)
+    void reset(auto & key, auto & value) const
     {
         key.reset();
         value.reset();
     }
 
     StateHandler state_handler;
-    uint64_t max_number_of_pairs;
+    extractKV::Limits limits;
+    std::shared_ptr<extractKV::KeyDictionary> key_dictionary;
+    std::shared_ptr<const extractKV::RowFilter> row_filter;
+    std::shared_ptr<extractKV::LatencyHistogram> latency_histogram;
 };
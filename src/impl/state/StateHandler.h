@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 
 namespace extractKV
@@ -28,10 +29,49 @@ namespace extractKV
             END
         };
 
+        /*
+         * Why a state dropped the token it was reading, reported by `KeyValuePairExtractor::validate`.
+         * */
+        enum class Discard : uint8_t
+        {
+            NONE,
+            // Escape sequence that could not be parsed. A value is still flushed, keys are dropped.
+            INVALID_ESCAPE_SEQUENCE,
+            // Input ended before the closing quoting character.
+            UNTERMINATED_QUOTE,
+            // `readKey` found a pair delimiter before the key value delimiter.
+            PAIR_DELIMITER_IN_KEY,
+            // `readKey` found a quoting character, the key is read again as a quoted key.
+            QUOTING_CHARACTER_IN_KEY,
+            // Key not followed by the key value delimiter.
+            MISSING_KEY_VALUE_DELIMITER,
+            EMPTY_QUOTED_KEY,
+            // `waitValue` found an escape character, the pair is dropped.
+            ESCAPE_CHARACTER_AT_VALUE_START
+        };
+
+        static constexpr std::string_view toString(Discard discard)
+        {
+            switch (discard)
+            {
+                case Discard::NONE: return "NONE";
+                case Discard::INVALID_ESCAPE_SEQUENCE: return "INVALID_ESCAPE_SEQUENCE";
+                case Discard::UNTERMINATED_QUOTE: return "UNTERMINATED_QUOTE";
+                case Discard::PAIR_DELIMITER_IN_KEY: return "PAIR_DELIMITER_IN_KEY";
+                case Discard::QUOTING_CHARACTER_IN_KEY: return "QUOTING_CHARACTER_IN_KEY";
+                case Discard::MISSING_KEY_VALUE_DELIMITER: return "MISSING_KEY_VALUE_DELIMITER";
+                case Discard::EMPTY_QUOTED_KEY: return "EMPTY_QUOTED_KEY";
+                case Discard::ESCAPE_CHARACTER_AT_VALUE_START: return "ESCAPE_CHARACTER_AT_VALUE_START";
+            }
+
+            return "UNKNOWN";
+        }
+
         struct NextState
         {
             std::size_t position_in_string;
             State state;
+            Discard discard = Discard::NONE;
         };
 
         StateHandler() = default;
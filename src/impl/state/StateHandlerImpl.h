@@ -4,6 +4,9 @@
 #include <impl/state/StateHandler.h>
 #include <impl/NeedleFactory.h>
 #include <impl/Configuration.h>
+#include <impl/ByteClassTable.h>
+#include <impl/AdaptiveSymbolSearch.h>
+#include <memory_resource>
 #include <string_view>
 #include <string>
 #include <vector>
@@ -15,7 +18,9 @@ namespace extractKV
     /*
     * Handles (almost) all states present in `StateHandler::State`. The description of each state responsibility can be found in
     * `StateHandler::State`. Advanced & optimized string search algorithms are used to search for control characters and form key value pairs.
-    * Each method returns a `StateHandler::NextState` object which contains the next state itself and the number of characters consumed by the previous state.
+    * Each method returns a `StateHandler::NextState` object which contains the next state itself, the number of characters consumed by the previous state
+    * and, if the previous state dropped what it was reading, the reason why.
+    * Searches go through a per extraction `AdaptiveSymbolSearch`, which picks between a byte class table and SIMD based on token length.
     *
     * The class is templated with a boolean that controls escaping support. As of now, there are two specializations:
     * `NoEscapingStateHandler` and `InlineEscapingStateHandler`.
@@ -25,7 +30,7 @@ namespace extractKV
     {
     public:
         explicit StateHandlerImpl(Configuration configuration_)
-                : configuration(std::move(configuration_))
+                : configuration(std::move(configuration_)), byte_classes(configuration, WITH_ESCAPING)
         {
             /* SearchNeedles do not change throughout the algorithm. Therefore, they are created only once in the constructor
              * to avoid unnecessary copies.
@@ -41,9 +46,9 @@ namespace extractKV
         /*
          * Find first character that is considered a valid key character and proceeds to READING_KEY like states.
          * */
-        [[nodiscard]] NextState waitKey(std::string_view file) const
+        [[nodiscard]] NextState waitKey(std::string_view file, AdaptiveSymbolSearch & search) const
         {
-            if (const auto * p = find_first_not_symbols_or_null(file, wait_needles))
+            if (const auto * p = search.findFirstNotSymbolOrNull(file, wait_needles, WAIT_CLASSES))
             {
                 const size_t character_position = p - file.begin();
                 if (isQuotingCharacter(*p))
@@ -64,13 +69,13 @@ namespace extractKV
          * Find first delimiter of interest (`read_needles`). Valid symbols are either `key_value_delimiter` and `escape_character` if escaping
          * support is on. If it finds a pair delimiter, it discards the key.
          * */
-        [[nodiscard]] NextState readKey(std::string_view file, auto & key) const
+        [[nodiscard]] NextState readKey(std::string_view file, auto & key, AdaptiveSymbolSearch & search) const
         {
             key.reset();
 
             size_t pos = 0;
 
-            while (const auto * p = find_first_symbols_or_null({file.begin() + pos, file.end()}, read_key_needles))
+            while (const auto * p = search.findFirstSymbolOrNull({file.begin() + pos, file.end()}, read_key_needles, READ_KEY_CLASSES))
             {
                 auto character_position = p - file.begin();
                 size_t next_pos = character_position + 1u;
@@ -84,7 +89,7 @@ namespace extractKV
 
                         if (!parsed_successfully)
                         {
-                            return {next_pos, State::WAITING_KEY};
+                            return {next_pos, State::WAITING_KEY, Discard::INVALID_ESCAPE_SEQUENCE};
                         }
                     }
                 }
@@ -96,29 +101,29 @@ namespace extractKV
                 }
                 else if (isPairDelimiter(*p))
                 {
-                    return {next_pos, State::WAITING_KEY};
+                    return {next_pos, State::WAITING_KEY, Discard::PAIR_DELIMITER_IN_KEY};
                 }
                 else if (isQuotingCharacter(*p))
                 {
-                    return {next_pos, State::READING_QUOTED_KEY};
+                    return {next_pos, State::READING_QUOTED_KEY, Discard::QUOTING_CHARACTER_IN_KEY};
                 }
 
                 pos = next_pos;
             }
 
-            return {file.size(), State::END};
+            return {file.size(), State::END, Discard::MISSING_KEY_VALUE_DELIMITER};
         }
 
         /*
          * Search for closing quoting character and process escape sequences along the way (if escaping support is turned on).
          * */
-        [[nodiscard]] NextState readQuotedKey(std::string_view file, auto & key) const
+        [[nodiscard]] NextState readQuotedKey(std::string_view file, auto & key, AdaptiveSymbolSearch & search) const
         {
             key.reset();
 
             size_t pos = 0;
 
-            while (const auto * p = find_first_symbols_or_null({file.begin() + pos, file.end()}, read_quoted_needles))
+            while (const auto * p = search.findFirstSymbolOrNull({file.begin() + pos, file.end()}, read_quoted_needles, READ_QUOTED_CLASSES))
             {
                 size_t character_position = p - file.begin();
                 size_t next_pos = character_position + 1u;
@@ -132,7 +137,7 @@ namespace extractKV
 
                         if (!parsed_successfully)
                         {
-                            return {next_pos, State::WAITING_KEY};
+                            return {next_pos, State::WAITING_KEY, Discard::INVALID_ESCAPE_SEQUENCE};
                         }
                     }
                 }
@@ -142,7 +147,7 @@ namespace extractKV
 
                     if (key.isEmpty())
                     {
-                        return {next_pos, State::WAITING_KEY};
+                        return {next_pos, State::WAITING_KEY, Discard::EMPTY_QUOTED_KEY};
                     }
 
                     return {next_pos, State::READING_KV_DELIMITER};
@@ -151,7 +156,7 @@ namespace extractKV
                 pos = next_pos;
             }
 
-            return {file.size(), State::END};
+            return {file.size(), State::END, Discard::UNTERMINATED_QUOTE};
         }
 
         /*
@@ -169,7 +174,7 @@ namespace extractKV
                 }
             }
 
-            return {0, State::WAITING_KEY};
+            return {0, State::WAITING_KEY, Discard::MISSING_KEY_VALUE_DELIMITER};
         }
 
         /*
@@ -193,7 +198,7 @@ namespace extractKV
                 {
                     if (isEscapeCharacter(current_character))
                     {
-                        return {pos, State::WAITING_KEY};
+                        return {pos, State::WAITING_KEY, Discard::ESCAPE_CHARACTER_AT_VALUE_START};
                     }
                 }
             }
@@ -205,13 +210,13 @@ namespace extractKV
          * Finds next delimiter of interest (`read_needles`). Valid symbols are either `pair_delimiter` and `escape_character` if escaping
          * support is on. If it finds a `key_value_delimiter`, it discards the value.
          * */
-        [[nodiscard]] NextState readValue(std::string_view file, auto & value) const
+        [[nodiscard]] NextState readValue(std::string_view file, auto & value, AdaptiveSymbolSearch & search) const
         {
             value.reset();
 
             size_t pos = 0;
 
-            while (const auto * p = find_first_symbols_or_null({file.begin() + pos, file.end()}, read_value_needles))
+            while (const auto * p = search.findFirstSymbolOrNull({file.begin() + pos, file.end()}, read_value_needles, READ_VALUE_CLASSES))
             {
                 const size_t character_position = p - file.begin();
                 size_t next_pos = character_position + 1u;
@@ -226,7 +231,7 @@ namespace extractKV
                         if (!parsed_successfully)
                         {
                             // Perform best-effort parsing and ignore invalid escape sequences at the end
-                            return {next_pos, State::FLUSH_PAIR};
+                            return {next_pos, State::FLUSH_PAIR, Discard::INVALID_ESCAPE_SEQUENCE};
                         }
                     }
                 }
@@ -248,13 +253,13 @@ namespace extractKV
         /*
          * Search for closing quoting character and process escape sequences along the way (if escaping support is turned on).
          * */
-        [[nodiscard]] NextState readQuotedValue(std::string_view file, auto & value) const
+        [[nodiscard]] NextState readQuotedValue(std::string_view file, auto & value, AdaptiveSymbolSearch & search) const
         {
             size_t pos = 0;
 
             value.reset();
 
-            while (const auto * p = find_first_symbols_or_null({file.begin() + pos, file.end()}, read_quoted_needles))
+            while (const auto * p = search.findFirstSymbolOrNull({file.begin() + pos, file.end()}, read_quoted_needles, READ_QUOTED_CLASSES))
             {
                 const size_t character_position = p - file.begin();
                 size_t next_pos = character_position + 1u;
@@ -268,7 +273,7 @@ namespace extractKV
 
                         if (!parsed_successfully)
                         {
-                            return {next_pos, State::WAITING_KEY};
+                            return {next_pos, State::WAITING_KEY, Discard::INVALID_ESCAPE_SEQUENCE};
                         }
                     }
                 }
@@ -282,12 +287,97 @@ namespace extractKV
                 pos = next_pos;
             }
 
-            return {file.size(), State::END};
+            return {file.size(), State::END, Discard::UNTERMINATED_QUOTE};
+        }
+
+        /*
+         * Helpers for looking a single key up without running the state machine over the whole input. Without quoting and escape
+         * characters, a pair delimiter always leads back to `WAITING_KEY`, whatever the state it is found in.
+         * */
+
+        /*
+         * Length of the longest prefix of `file` without quoting and escape characters.
+         * */
+        [[nodiscard]] size_t unquotedPrefixLength(std::string_view file) const
+        {
+            const auto * p = find_first_symbols_or_null(file, read_quoted_needles);
+            return p ? p - file.begin() : file.size();
+        }
+
+        /*
+         * Position right after the last pair delimiter of `file`, zero if there is none.
+         * */
+        [[nodiscard]] size_t positionAfterLastPairDelimiter(std::string_view file) const
+        {
+            for (size_t pos = file.size(); pos > 0; --pos)
+            {
+                if (isPairDelimiter(file[pos - 1]))
+                {
+                    return pos;
+                }
+            }
+
+            return 0;
+        }
+
+        /*
+         * Position of the first pair delimiter of `file`, `file.size()` if there is none. `file` must not contain quoting and escape
+         * characters.
+         * */
+        [[nodiscard]] size_t findPairDelimiter(std::string_view file) const
+        {
+            const auto * p = find_first_symbols_or_null(file, read_value_needles);
+            return p ? p - file.begin() : file.size();
+        }
+
+        /*
+         * Whether `readKey` reads `key` as is, i.e. it is not empty and contains no control character.
+         * */
+        [[nodiscard]] bool isPlainKey(std::string_view key) const
+        {
+            return !key.empty() && !byte_classes.findFirstOrNull<true>(key.begin(), key.end(), READ_KEY_CLASSES);
+        }
+
+        /*
+         * Whether the state machine starts reading a key at `position`, given that `file[0, position)` contains no quoting and escape
+         * characters and `file[position]` is not a control character. That is the case if only `WAITING_KEY` skippable characters,
+         * including at least one pair delimiter, separate it from the previous token, or if there is no previous token.
+         * */
+        [[nodiscard]] bool isKeyStart(std::string_view file, size_t position) const
+        {
+            for (; position > 0; --position)
+            {
+                const auto character = file[position - 1];
+
+                if (isPairDelimiter(character))
+                {
+                    return true;
+                }
+
+                if (!isKeyValueDelimiter(character))
+                {
+                    return false;
+                }
+            }
+
+            return true;
         }
 
         const Configuration configuration;
+        const ByteClassTable byte_classes;
 
     private:
+        using enum ByteClassTable::Class;
+
+        static constexpr uint8_t ESCAPE_CLASS = WITH_ESCAPING ? ESCAPE_CHARACTER : REGULAR;
+
+        /* Same characters as the needles created by `NeedleFactory`, expressed as `ByteClassTable` classes.
+         * */
+        static constexpr uint8_t WAIT_CLASSES = KEY_VALUE_DELIMITER | PAIR_DELIMITER | ESCAPE_CLASS;
+        static constexpr uint8_t READ_KEY_CLASSES = KEY_VALUE_DELIMITER | QUOTING_CHARACTER | PAIR_DELIMITER | ESCAPE_CLASS;
+        static constexpr uint8_t READ_VALUE_CLASSES = QUOTING_CHARACTER | PAIR_DELIMITER | ESCAPE_CLASS;
+        static constexpr uint8_t READ_QUOTED_CLASSES = QUOTING_CHARACTER | ESCAPE_CLASS;
+
         SearchSymbols wait_needles;
         SearchSymbols read_key_needles;
         SearchSymbols read_value_needles;
@@ -321,8 +411,7 @@ namespace extractKV
 
         bool isPairDelimiter(char character) const
         {
-            const auto & pair_delimiters = configuration.pair_delimiters;
-            return std::find(pair_delimiters.begin(), pair_delimiters.end(), character) != pair_delimiters.end();
+            return byte_classes.is(character, PAIR_DELIMITER);
         }
 
         bool isQuotingCharacter(char character) const
@@ -398,9 +487,12 @@ namespace extractKV
 
     struct InlineEscapingStateHandler : public StateHandlerImpl<true>
     {
+        /*
+         * Owns the unescaped token. The buffer allocates from the memory resource of the response, if it has one, see `ResponseSink`.
+         * */
         class StringWriter
         {
-            std::string element;
+            std::pmr::string element;
             uint64_t prev_commit_pos;
 
         public:
@@ -408,6 +500,10 @@ namespace extractKV
             : prev_commit_pos(element.size())
             {}
 
+            explicit StringWriter(std::pmr::memory_resource * resource)
+            : element(resource), prev_commit_pos(element.size())
+            {}
+
             ~StringWriter()
             {
                 // Make sure that ColumnString invariants are not broken.
@@ -438,7 +534,7 @@ namespace extractKV
                 return element.size() == prev_commit_pos;
             }
 
-            std::string commit()
+            std::string_view commit()
             {
                 return element;
             }
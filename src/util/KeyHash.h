@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/*
+ * Fast 64-bit hash for short keys, used to look keys up in `extractKV::KeyDictionary`. Consumes the key eight bytes at a time with a
+ * multiply-xorshift round per word, then mixes in the length. Not meant to be DoS resistant.
+ *
+ * `Hasher` computes the same hash over a key that arrives in several chunks, so that it can be fed while the key is being read.
+ * */
+namespace KeyHash
+{
+    inline constexpr uint64_t SEED = 0x9E3779B97F4A7C15ull;
+    inline constexpr uint64_t MULTIPLIER = 0xFF51AFD7ED558CCDull;
+
+    inline uint64_t mixWord(uint64_t hash, uint64_t word)
+    {
+        hash = (hash ^ word) * MULTIPLIER;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint64_t finalize(uint64_t hash, uint64_t length)
+    {
+        hash = (hash ^ length) * MULTIPLIER;
+        hash ^= hash >> 29;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint64_t hash(std::string_view key)
+    {
+        uint64_t hash = SEED;
+
+        const char * pos = key.data();
+        const char * end = pos + key.size();
+
+        for (; pos + 8 <= end; pos += 8)
+        {
+            uint64_t word;
+            memcpy(&word, pos, sizeof(word));
+            hash = mixWord(hash, word);
+        }
+
+        if (pos != end)
+        {
+            uint64_t word = 0;
+            memcpy(&word, pos, end - pos);
+            hash = mixWord(hash, word);
+        }
+
+        return finalize(hash, key.size());
+    }
+
+    class Hasher
+    {
+    public:
+        void update(std::string_view chunk)
+        {
+            const char * pos = chunk.data();
+            const char * end = pos + chunk.size();
+
+            length += chunk.size();
+
+            if (pending_bytes)
+            {
+                const auto to_copy = std::min<size_t>(8u - pending_bytes, end - pos);
+                memcpy(reinterpret_cast<char *>(&pending_word) + pending_bytes, pos, to_copy);
+
+                pos += to_copy;
+                pending_bytes += to_copy;
+
+                if (pending_bytes < 8u)
+                {
+                    return;
+                }
+
+                state = mixWord(state, pending_word);
+                pending_word = 0;
+                pending_bytes = 0;
+            }
+
+            for (; pos + 8 <= end; pos += 8)
+            {
+                uint64_t word;
+                memcpy(&word, pos, sizeof(word));
+                state = mixWord(state, word);
+            }
+
+            if (pos != end)
+            {
+                memcpy(&pending_word, pos, end - pos);
+                pending_bytes = end - pos;
+            }
+        }
+
+        uint64_t finalize() const
+        {
+            return KeyHash::finalize(pending_bytes ? mixWord(state, pending_word) : state, length);
+        }
+
+        void reset()
+        {
+            *this = Hasher();
+        }
+
+    private:
+        uint64_t state = SEED;
+        uint64_t pending_word = 0;
+        size_t pending_bytes = 0;
+        uint64_t length = 0;
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/** Linux USDT probes of the `kvp_extractor` provider, for `bpftrace` / `perf` on running processes:
+  *
+  *   extract_start(data, size)                      public `extract` call, before the row filter
+  *   extract_end(size, number_of_pairs, kept)
+  *   row_start(data, size)                          every run of the state machine, `extractValue` runs it on parts of the input
+  *   row_end(size, number_of_pairs, error)          `error` is 1 + `ExtractionError::Code`, 0 if none
+  *   pair_flush(offset, key_length, value_length)   `offset` of the end of the pair in the row
+  *   discard(reason, begin, end)                    dropped token, `reason` is `StateHandler::Discard`, 1 for invalid escapes
+  *   limit_hit(kind, policy, offset)                `Limits::Kind` and `Limits::Policy`
+  *
+  * e.g. `bpftrace -e 'usdt:./app:kvp_extractor:row_end { @[arg1] = hist(arg0); }'`.
+  *
+  * Probes are compiled in by default on systems with <sys/sdt.h> (systemtap-sdt-dev), `-DKVP_EXTRACTOR_ENABLE_USDT=OFF` leaves them
+  * out. A probe that is not attached is a single NOP, plus whatever it takes to have its arguments in registers. Otherwise `KVP_PROBE`
+  * expands to nothing.
+  */
+#if defined(KVP_EXTRACTOR_ENABLE_USDT) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define KVP_PROBE(name, ...) STAP_PROBEV(kvp_extractor, name __VA_OPT__(,) __VA_ARGS__)
+#define KVP_PROBES_ENABLED 1
+#else
+#define KVP_PROBE(name, ...) do {} while (false)
+#define KVP_PROBES_ENABLED 0
+#endif
@@ -0,0 +1,68 @@
+#include "ReadBufferFromFileDescriptor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+ReadBufferFromFileDescriptor::ReadBufferFromFileDescriptor(int fd_, size_t buf_size)
+        : ReadBuffer(nullptr, 0), fd(fd_), memory(std::make_unique<char[]>(buf_size))
+{
+    set(memory.get(), buf_size);
+}
+
+bool ReadBufferFromFileDescriptor::nextImpl()
+{
+    ssize_t bytes_read;
+
+    do
+    {
+        bytes_read = ::read(fd, internal_buffer.begin(), internal_buffer.size());
+    }
+    while (bytes_read < 0 && errno == EINTR);
+
+    if (bytes_read < 0)
+    {
+        throw std::runtime_error ("Cannot read from file descriptor: " + std::string(strerror(errno)));
+    }
+
+    if (bytes_read == 0)
+    {
+        return false;
+    }
+
+    working_buffer = internal_buffer;
+    working_buffer.resize(bytes_read);
+
+    return true;
+}
+
+namespace
+{
+    int openForReading(const std::string & file_name)
+    {
+        const int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            throw std::runtime_error ("Cannot open file " + file_name + ": " + std::string(strerror(errno)));
+        }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        return fd;
+    }
+}
+
+ReadBufferFromFile::ReadBufferFromFile(const std::string & file_name, size_t buf_size)
+        : ReadBufferFromFileDescriptor(openForReading(file_name), buf_size)
+{
+}
+
+ReadBufferFromFile::~ReadBufferFromFile()
+{
+    ::close(fd);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "ReadBuffer.h"
+
+/** Reads from a file descriptor through an owned buffer, one `read` call per `next()`.
+  * The buffer is allocated once and reused, so memory stays bounded no matter how much data goes through it.
+  */
+class ReadBufferFromFileDescriptor : public ReadBuffer
+{
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit ReadBufferFromFileDescriptor(int fd_, size_t buf_size = DEFAULT_BUFFER_SIZE);
+
+    int getFD() const { return fd; }
+
+protected:
+    int fd;
+
+private:
+    bool nextImpl() override;
+
+    std::unique_ptr<char[]> memory;
+};
+
+/** Opens the file for reading and closes it in the destructor.
+  */
+class ReadBufferFromFile : public ReadBufferFromFileDescriptor
+{
+public:
+    explicit ReadBufferFromFile(const std::string & file_name, size_t buf_size = DEFAULT_BUFFER_SIZE);
+
+    ReadBufferFromFile(const ReadBufferFromFile &) = delete;
+
+    ~ReadBufferFromFile() override;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "ReadBuffer.h"
+
+/** Splits the data of a `ReadBuffer` into records separated by `delimiter`, e.g. lines.
+  *
+  * A record that lies entirely in the working buffer is returned in place, without a copy. Only a record that straddles the end of
+  *  the buffer is assembled in an internal string, which is reused and therefore grows to the longest such record, not to the input.
+  * The returned view is valid until the next call to `next()`. A delimiter at the very end of the data does not start an empty record.
+  */
+class RecordReader
+{
+public:
+    RecordReader(ReadBuffer & in_, char delimiter_) : in(in_), delimiter(delimiter_) {}
+
+    bool next(std::string_view & record)
+    {
+        if (in.eof())
+        {
+            return false;
+        }
+
+        if (char * end = findDelimiter())
+        {
+            record = std::string_view(in.position(), end);
+            in.position() = end + 1;
+            return true;
+        }
+
+        carry.assign(in.position(), in.buffer().end());
+        in.position() = in.buffer().end();
+
+        while (!in.eof())
+        {
+            if (char * end = findDelimiter())
+            {
+                carry.append(in.position(), end);
+                in.position() = end + 1;
+                break;
+            }
+
+            carry.append(in.position(), in.buffer().end());
+            in.position() = in.buffer().end();
+        }
+
+        record = carry;
+        return true;
+    }
+
+private:
+    char * findDelimiter() const
+    {
+        return static_cast<char *>(memchr(in.position(), delimiter, in.available()));
+    }
+
+    ReadBuffer & in;
+    const char delimiter;
+
+    std::string carry;
+};
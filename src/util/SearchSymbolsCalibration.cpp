@@ -0,0 +1,110 @@
+#include <util/SearchSymbolsCalibration.h>
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+namespace
+{
+    /// 0 - not measured yet, otherwise `Kernel` + 1.
+    std::atomic<uint8_t> fastest_kernels[SearchSymbols::BUFFER_SIZE + 1];
+
+#if KVP_SSE42_KERNEL
+    /// Scans `haystack` the same way the state handlers do: one search per token, restarting right after each match.
+    size_t scan(std::string_view haystack, const SearchSymbols & symbols)
+    {
+        size_t matches = 0;
+        const char * pos = haystack.begin();
+
+        while (const auto * p = find_first_symbols_or_null({pos, haystack.end()}, symbols))
+        {
+            ++matches;
+            pos = p + 1;
+        }
+
+        return matches;
+    }
+
+    std::chrono::nanoseconds bestOf(std::string_view haystack, const SearchSymbols & symbols)
+    {
+        static constexpr auto NUMBER_OF_TRIALS = 7u;
+
+        auto best = std::chrono::nanoseconds::max();
+        volatile size_t sink = 0;
+
+        for (auto trial = 0u; trial < NUMBER_OF_TRIALS; ++trial)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            sink = sink + scan(haystack, symbols);
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+        }
+
+        return best;
+    }
+#endif
+}
+
+SearchSymbols::Kernel SearchSymbolsCalibration::fastestKernel(size_t num_chars)
+{
+    if (num_chars == 0 || num_chars > SearchSymbols::BUFFER_SIZE)
+    {
+        return SearchSymbols::defaultKernel(num_chars);
+    }
+
+    auto & cached = fastest_kernels[num_chars];
+
+    if (auto kernel = cached.load(std::memory_order_relaxed))
+    {
+        return static_cast<SearchSymbols::Kernel>(kernel - 1);
+    }
+
+    // Concurrent first calls may measure twice, both results are valid.
+    auto kernel = measure(num_chars);
+    cached.store(static_cast<uint8_t>(kernel) + 1, std::memory_order_relaxed);
+
+    return kernel;
+}
+
+SearchSymbols SearchSymbolsCalibration::calibrate(std::string needles)
+{
+    auto kernel = fastestKernel(needles.size());
+    return SearchSymbols {std::move(needles), kernel};
+}
+
+SearchSymbols::Kernel SearchSymbolsCalibration::measure(size_t num_chars)
+{
+#if KVP_SSE42_KERNEL
+    if (!SearchSymbols::hasSSE42())
+    {
+        return SearchSymbols::Kernel::SSE2;
+    }
+
+    // Tokens in key-value pair inputs are usually a few dozen bytes long, use that as the distance between matches.
+    static constexpr auto HAYSTACK_SIZE = 16u * 1024u;
+    static constexpr auto DISTANCE_BETWEEN_MATCHES = 32u;
+
+    std::string needles;
+
+    for (size_t i = 0; i < num_chars; ++i)
+    {
+        needles.push_back(static_cast<char>(1 + i));
+    }
+
+    std::string haystack(HAYSTACK_SIZE, 'a');
+
+    for (size_t i = DISTANCE_BETWEEN_MATCHES; i < haystack.size(); i += DISTANCE_BETWEEN_MATCHES)
+    {
+        // Cycle through all the needles, the distance would skip most of them
+        haystack[i] = needles[(i / DISTANCE_BETWEEN_MATCHES) % num_chars];
+    }
+
+    const auto sse2 = bestOf(haystack, SearchSymbols {needles, SearchSymbols::Kernel::SSE2});
+    const auto sse42 = bestOf(haystack, SearchSymbols {needles, SearchSymbols::Kernel::SSE42});
+
+    return sse42 < sse2 ? SearchSymbols::Kernel::SSE42 : SearchSymbols::Kernel::SSE2;
+#else
+    return SearchSymbols::defaultKernel(num_chars);
+#endif
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <util/find_symbols.h>
+
+/*
+ * Picks the `find_first_symbols` kernel (SSE 2 or SSE 4.2) for runtime `SearchSymbols` on the running CPU.
+ *
+ * The crossover between `pcmpestri` and a chain of `pcmpeqb` depends on the micro-architecture, so instead of the static
+ * threshold used by `SearchSymbols::defaultKernel`, both kernels are timed on a synthetic haystack the first time a given number of
+ * needles is requested. The result is cached per number of needles for the lifetime of the process and shared across threads.
+ *
+ * The SSE 4.2 kernel doesn't need SSE 4.2 to be enabled at compile time. On CPUs without it, or on builds without SSE at all, there
+ * is nothing to choose from and SSE 2 is always returned.
+ * */
+class SearchSymbolsCalibration
+{
+public:
+    static SearchSymbols::Kernel fastestKernel(size_t num_chars);
+
+    /// Returns `needles` with the fastest kernel for its size.
+    static SearchSymbols calibrate(std::string needles);
+
+private:
+    static SearchSymbols::Kernel measure(size_t num_chars);
+};
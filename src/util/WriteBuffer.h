@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+#include "BufferBase.h"
+
+
+/** A simple abstract class for buffered data writing (char sequences) somewhere.
+  * Unlike std::ostream, it provides access to the internal buffer,
+  *  and also allows you to manually manage the position inside the buffer.
+  *
+  * The buffer is flushed by `next()` when it is full, so writing a byte is a compare and a store, without a virtual call.
+  * Data still in the buffer is not written by the destructor, call `next()` (or `finalize()`) once done writing.
+  *
+  * Derived classes must implement the nextImpl() method.
+  */
+class WriteBuffer : public BufferBase
+{
+public:
+    WriteBuffer(Position ptr, size_t size) : BufferBase(ptr, size, 0) {}
+
+    WriteBuffer(const WriteBuffer &) = delete;
+
+    virtual ~WriteBuffer() = default;
+
+    /** write the data in the buffer (from the beginning of the buffer to the current position);
+      * set the position to the beginning; throw an exception, if something is wrong
+      */
+    void next()
+    {
+        if (!offset())
+            return;
+
+        bytes += offset();
+        nextImpl();
+        pos = working_buffer.begin();
+    }
+
+    inline void nextIfAtEnd()
+    {
+        if (!hasPendingData())
+            next();
+    }
+
+    void write(const char * from, size_t n)
+    {
+        size_t bytes_copied = 0;
+
+        while (bytes_copied < n)
+        {
+            nextIfAtEnd();
+            size_t bytes_to_copy = std::min(static_cast<size_t>(working_buffer.end() - pos), n - bytes_copied);
+            ::memcpy(pos, from + bytes_copied, bytes_to_copy);
+            pos += bytes_to_copy;
+            bytes_copied += bytes_to_copy;
+        }
+    }
+
+    void write(std::string_view s)
+    {
+        write(s.data(), s.size());
+    }
+
+    inline void write(char x)
+    {
+        nextIfAtEnd();
+        *pos = x;
+        ++pos;
+    }
+
+    /// Writes whatever is left in the buffer.
+    void finalize()
+    {
+        next();
+    }
+
+private:
+    /** Write the data in the buffer (from the beginning of the buffer to the current position).
+      * Throw an exception if something is wrong.
+      */
+    virtual void nextImpl() = 0;
+};
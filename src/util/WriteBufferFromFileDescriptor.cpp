@@ -0,0 +1,60 @@
+#include "WriteBufferFromFileDescriptor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+WriteBufferFromFileDescriptor::WriteBufferFromFileDescriptor(int fd_, size_t buf_size)
+        : WriteBuffer(nullptr, 0), fd(fd_), memory(std::make_unique<char[]>(buf_size))
+{
+    set(memory.get(), buf_size, 0);
+}
+
+void WriteBufferFromFileDescriptor::nextImpl()
+{
+    size_t bytes_written = 0;
+
+    while (bytes_written != offset())
+    {
+        const ssize_t res = ::write(fd, working_buffer.begin() + bytes_written, offset() - bytes_written);
+
+        if (res < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (res < 0)
+        {
+            throw std::runtime_error ("Cannot write to file descriptor: " + std::string(strerror(errno)));
+        }
+
+        bytes_written += res;
+    }
+}
+
+namespace
+{
+    int openForWriting(const std::string & file_name)
+    {
+        const int fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+        if (fd < 0)
+        {
+            throw std::runtime_error ("Cannot open file " + file_name + ": " + std::string(strerror(errno)));
+        }
+
+        return fd;
+    }
+}
+
+WriteBufferFromFile::WriteBufferFromFile(const std::string & file_name, size_t buf_size)
+        : WriteBufferFromFileDescriptor(openForWriting(file_name), buf_size)
+{
+}
+
+WriteBufferFromFile::~WriteBufferFromFile()
+{
+    ::close(fd);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "WriteBuffer.h"
+
+/** Writes to a file descriptor through an owned buffer, the whole buffer in one `write` call (or more, for short writes) per `next()`.
+  */
+class WriteBufferFromFileDescriptor : public WriteBuffer
+{
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit WriteBufferFromFileDescriptor(int fd_, size_t buf_size = DEFAULT_BUFFER_SIZE);
+
+    int getFD() const { return fd; }
+
+protected:
+    int fd;
+
+private:
+    void nextImpl() override;
+
+    std::unique_ptr<char[]> memory;
+};
+
+/** Creates (or truncates) the file for writing and closes it in the destructor.
+  */
+class WriteBufferFromFile : public WriteBufferFromFileDescriptor
+{
+public:
+    explicit WriteBufferFromFile(const std::string & file_name, size_t buf_size = DEFAULT_BUFFER_SIZE);
+
+    WriteBufferFromFile(const WriteBufferFromFile &) = delete;
+
+    ~WriteBufferFromFile() override;
+};
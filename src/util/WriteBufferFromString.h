@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "WriteBuffer.h"
+
+/** Writes into an owned `std::string`, which doubles in size whenever it is full. `str()` returns the data written so far.
+  */
+class WriteBufferFromString : public WriteBuffer
+{
+public:
+    explicit WriteBufferFromString(size_t initial_size = 256) : WriteBuffer(nullptr, 0), s(std::max<size_t>(initial_size, 1), '\0')
+    {
+        set(s.data(), s.size(), 0);
+    }
+
+    /// Valid until the next write.
+    std::string_view str() const
+    {
+        return {s.data(), bytes + offset()};
+    }
+
+    void clear()
+    {
+        bytes = 0;
+        set(s.data(), s.size(), 0);
+    }
+
+private:
+    void nextImpl() override
+    {
+        // `next()` has already counted the buffer in `bytes`, continue writing right after it.
+        s.resize(s.size() * 2);
+        set(s.data() + bytes, s.size() - bytes, 0);
+    }
+
+    std::string s;
+};
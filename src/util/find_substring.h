@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** find_first_substring(begin, end, needle)
+  *
+  * Returns a pointer to the first occurrence of `needle` in [begin, end), or `end` if there is none. An empty needle matches at `begin`.
+  *
+  * Uses the first and last byte filter of SIMD memmem: 16 candidate positions are checked at once by comparing the bytes at the
+  * candidate start with the first byte of the needle and the bytes `needle.size() - 1` further with its last byte. Only the positions
+  * passing both comparisons are verified with `memcmp`, which keeps the number of false positives low even for short needles.
+  */
+inline const char * find_first_substring(const char * const begin, const char * const end, std::string_view needle)
+{
+    const size_t needle_size = needle.size();
+
+    if (needle_size == 0)
+        return begin;
+
+    if (static_cast<size_t>(end - begin) < needle_size)
+        return end;
+
+    /// Last position where the needle can start.
+    const char * const last_start = end - needle_size;
+    const char * pos = begin;
+
+    const auto matches_middle = [&](const char * candidate)
+    {
+        return needle_size <= 2 || memcmp(candidate + 1, needle.data() + 1, needle_size - 2) == 0;
+    };
+
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+
+    for (; pos + 15 <= last_start; pos += 16)
+    {
+        const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos + needle_size - 1));
+
+        uint32_t bit_mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+
+        while (bit_mask)
+        {
+            const char * candidate = pos + __builtin_ctz(bit_mask);
+
+            if (matches_middle(candidate))
+                return candidate;
+
+            bit_mask &= bit_mask - 1;
+        }
+    }
+#endif
+
+    for (; pos <= last_start; ++pos)
+        if (*pos == needle.front() && pos[needle_size - 1] == needle.back() && matches_middle(pos))
+            return pos;
+
+    return end;
+}
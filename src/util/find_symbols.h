@@ -1,13 +1,28 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 #include <array>
 
 #if defined(__SSE2__)
 #include <emmintrin.h>
 #endif
+
+/// The SSE 4.2 kernel of the runtime `SearchSymbols` overloads is compiled with a target attribute when the build doesn't enable
+/// SSE 4.2 itself, and only picked on CPUs that support it, see `SearchSymbols::hasSSE42`.
 #if defined(__SSE4_2__)
+#define KVP_SSE42_KERNEL 1
+#define KVP_SSE42_TARGET
+#elif defined(__SSE2__) && defined(__GNUC__)
+#define KVP_SSE42_KERNEL 1
+#define KVP_SSE42_TARGET __attribute__((target("sse4.2")))
+#else
+#define KVP_SSE42_KERNEL 0
+#endif
+
+#if KVP_SSE42_KERNEL
 #include <nmmintrin.h>
 #endif
 
@@ -28,6 +43,14 @@
   * In the case of parsing tab separated dump with short strings, there is no performance degradation over trivial loop.
   *
   * Note: the optimal threshold to choose between SSE 2 and SSE 4.2 may depend on CPU model.
+  * The runtime `SearchSymbols` overloads use the kernel stored in `SearchSymbols::kernel`, which can be measured on the running CPU
+  *  with `SearchSymbolsCalibration`. Their SSE 4.2 kernel is available on any x86-64 build and checked for at runtime.
+  * The compile time overloads keep the static threshold, and only use SSE 4.2 if the build enables it.
+  *
+  * find_first_symbols_or_control<c1, c2, ...>(begin, end):
+  *
+  * Same as find_first_symbols, but also stops at ASCII control characters (bytes below 0x20), which are too many to list as symbols.
+  * Used by the output serializers to find the next byte that has to be escaped or quoted.
   *
   * find_last_symbols_or_null<c1, c2, ...>(begin, end):
   *
@@ -39,17 +62,36 @@ struct SearchSymbols
 {
     static constexpr auto BUFFER_SIZE = 16;
 
+    /// Kernel used by the runtime `SearchSymbols` overloads. See `SearchSymbolsCalibration` for picking it on the running CPU.
+    enum class Kernel
+    {
+        SSE2,
+        SSE42,
+    };
+
     SearchSymbols() = default;
 
     explicit SearchSymbols(std::string in)
-            : str(std::move(in))
+            : SearchSymbols(in, defaultKernel(in.size()))
+    {
+    }
+
+    SearchSymbols(std::string in, Kernel kernel_)
+            : str(std::move(in)), kernel(kernel_ == Kernel::SSE42 && !hasSSE42() ? Kernel::SSE2 : kernel_)
     {
-#if defined(__SSE4_2__)
         if (str.size() > BUFFER_SIZE)
         {
             throw std::runtime_error("SearchSymbols can contain at most " + std::to_string(BUFFER_SIZE) + " symbols and " + std::to_string(str.size()) + " was provided\n");
         }
 
+#if defined(__SSE2__)
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            sse2_needles[i] = _mm_set1_epi8(str[i]);
+        }
+#endif
+
+#if KVP_SSE42_KERNEL
         char tmp_safety_buffer[BUFFER_SIZE] = {0};
 
         memcpy(tmp_safety_buffer, str.data(), str.size());
@@ -58,10 +100,42 @@ struct SearchSymbols
 #endif
     }
 
+    /// Static threshold, used when the kernel was not calibrated.
+    static Kernel defaultKernel(size_t num_chars)
+    {
+        if (num_chars >= 5 && hasSSE42())
+            return Kernel::SSE42;
+
+        return Kernel::SSE2;
+    }
+
+    /// Whether the running CPU can run the SSE 4.2 kernel.
+    static bool hasSSE42()
+    {
 #if defined(__SSE4_2__)
+        return true;
+#elif KVP_SSE42_KERNEL
+        static const bool supported = []
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.2") != 0;
+        }();
+
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+#if KVP_SSE42_KERNEL
     __m128i simd_vector;
+#endif
+#if defined(__SSE2__)
+    /// `_mm_set1_epi8` of every symbol, prepared once instead of on every search.
+    __m128i sse2_needles[BUFFER_SIZE];
 #endif
     std::string str;
+    Kernel kernel = Kernel::SSE2;
 };
 
 namespace detail
@@ -133,6 +207,19 @@ namespace detail
 
         return accumulator;
     }
+
+    inline __m128i mm_is_in_execute(__m128i bytes, const __m128i * needles, size_t num_chars)
+    {
+        __m128i accumulator = _mm_setzero_si128();
+
+        for (size_t i = 0; i < num_chars; ++i)
+        {
+            __m128i eq = _mm_cmpeq_epi8(bytes, needles[i]);
+            accumulator = _mm_or_si128(accumulator, eq);
+        }
+
+        return accumulator;
+    }
 #endif
 
     template <bool positive>
@@ -206,6 +293,33 @@ namespace detail
     }
 
 
+    template <bool positive, ReturnMode return_mode>
+    inline const char * find_first_symbols_sse2(const char * const begin, const char * const end, const SearchSymbols & symbols)
+    {
+        const char * pos = begin;
+
+        const auto num_chars = symbols.str.size();
+
+#if defined(__SSE2__)
+        for (; pos + 15 < end; pos += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+
+            __m128i eq = mm_is_in_execute(bytes, symbols.sse2_needles, num_chars);
+
+            uint16_t bit_mask = maybe_negate<positive>(uint16_t(_mm_movemask_epi8(eq)));
+            if (bit_mask)
+                return pos + __builtin_ctz(bit_mask);
+        }
+#endif
+
+        for (; pos < end; ++pos)
+            if (maybe_negate<positive>(is_in(*pos, symbols.str.data(), num_chars)))
+                return pos;
+
+        return return_mode == ReturnMode::End ? end : nullptr;
+    }
+
     template <bool positive, ReturnMode return_mode, char... symbols>
     inline const char * find_last_symbols_sse2(const char * const begin, const char * const end)
     {
@@ -286,13 +400,14 @@ namespace detail
     }
 
     template <bool positive, ReturnMode return_mode>
+    KVP_SSE42_TARGET
     inline const char * find_first_symbols_sse42(const char * const begin, const char * const end, const SearchSymbols & symbols)
     {
         const char * pos = begin;
 
         const auto num_chars = symbols.str.size();
 
-#if defined(__SSE4_2__)
+#if KVP_SSE42_KERNEL
         constexpr int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT;
 
     const __m128i set = symbols.simd_vector;
@@ -323,6 +438,33 @@ namespace detail
 
 /// NOTE No SSE 4.2 implementation for find_last_symbols_or_null. Not worth to do.
 
+    template <char... symbols>
+    inline const char * find_first_symbols_or_control_sse2(const char * const begin, const char * const end)
+    {
+        const char * pos = begin;
+
+#if defined(__SSE2__)
+        for (; pos + 15 < end; pos += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+
+            /// There is no unsigned byte comparison in SSE 2, `min(x, 0x1F) == x` is `x <= 0x1F`.
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes);
+            __m128i eq = _mm_or_si128(control, mm_is_in<symbols...>(bytes));
+
+            uint16_t bit_mask = uint16_t(_mm_movemask_epi8(eq));
+            if (bit_mask)
+                return pos + __builtin_ctz(bit_mask);
+        }
+#endif
+
+        for (; pos < end; ++pos)
+            if (static_cast<unsigned char>(*pos) < 0x20 || is_in<symbols...>(*pos))
+                return pos;
+
+        return end;
+    }
+
     template <bool positive, ReturnMode return_mode, char... symbols>
     inline const char * find_first_symbols_dispatch(const char * begin, const char * end)
     requires(0 <= sizeof...(symbols) && sizeof...(symbols) <= 16)
@@ -338,12 +480,12 @@ namespace detail
     template <bool positive, ReturnMode return_mode>
     inline const char * find_first_symbols_dispatch(const std::string_view haystack, const SearchSymbols & symbols)
     {
-#if defined(__SSE4_2__)
-        if (symbols.str.size() >= 5)
+#if KVP_SSE42_KERNEL
+        if (symbols.kernel == SearchSymbols::Kernel::SSE42)
         return find_first_symbols_sse42<positive, return_mode>(haystack.begin(), haystack.end(), symbols);
     else
 #endif
-        return find_first_symbols_sse2<positive, return_mode>(haystack.begin(), haystack.end(), symbols.str.data(), symbols.str.size());
+        return find_first_symbols_sse2<positive, return_mode>(haystack.begin(), haystack.end(), symbols);
     }
 
 }
@@ -419,6 +561,13 @@ inline const char * find_first_not_symbols_or_null(std::string_view haystack, co
     return detail::find_first_symbols_dispatch<false, detail::ReturnMode::Nullptr>(haystack, symbols);
 }
 
+template <char... symbols>
+inline const char * find_first_symbols_or_control(const char * begin, const char * end)
+requires(0 < sizeof...(symbols) && sizeof...(symbols) <= 16)
+{
+    return detail::find_first_symbols_or_control_sse2<symbols...>(begin, end);
+}
+
 template <char... symbols>
 inline const char * find_last_symbols_or_null(const char * begin, const char * end)
 {
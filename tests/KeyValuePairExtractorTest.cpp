@@ -1,7 +1,24 @@
 #include <gtest/gtest.h>
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <atomic>
+#include <thread>
 #include <KeyValuePairExtractorBuilder.h>
+#include <impl/AdaptiveSymbolSearch.h>
+#include <impl/ByteClassTable.h>
+#include <impl/CountingMemoryResource.h>
+#include <impl/NeedleFactory.h>
+#include <impl/SchemaInference.h>
+#include <impl/serializer/ArrowStreamWriter.h>
+#include <impl/serializer/CsvSerializer.h>
+#include <impl/serializer/LogfmtSerializer.h>
+#include <impl/serializer/NdjsonSerializer.h>
+#include <impl/serializer/TsvSerializer.h>
+#include <util/KeyHash.h>
+#include <util/ReadBufferFromFileDescriptor.h>
+#include <util/RecordReader.h>
+#include <util/SearchSymbolsCalibration.h>
+#include <util/WriteBufferFromString.h>
 
 
 struct LazyKeyValuePairExtractorTestCase {
@@ -188,3 +205,1084 @@ TEST(KeyValuePairExtractorTests, Simplest) {
     EXPECT_EQ(result, expected_output);
 }
 
+
+TEST(KeyValuePairExtractorTests, HandleReusesOutputAcrossCalls) {
+    auto handle = KeyValuePairExtractorBuilder().buildHandleWithEscaping();
+
+    const char * first_input = "name:neymar age:31";
+    EXPECT_EQ(handle.extract(first_input), (std::unordered_map<std::string, std::string> {{"name", "neymar"}, {"age", "31"}}));
+
+    std::string_view second_input = "team:psg";
+    EXPECT_EQ(handle.extract(second_input), (std::unordered_map<std::string, std::string> {{"team", "psg"}}));
+}
+
+TEST(KeyValuePairExtractorTests, SharedAcrossThreads) {
+    const std::shared_ptr<const KeyValuePairExtractor> extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    std::unordered_map<std::string, std::string> expected_output {{"name", "neymar"}, {"age", "31"}, {"team", "psg"}};
+
+    std::vector<std::thread> threads;
+    std::atomic<size_t> mismatches = 0;
+
+    for (auto i = 0u; i < 4u; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            for (auto j = 0u; j < 1000u; ++j)
+            {
+                if (extractor->extract("name:neymar age:31 team:psg") != expected_output)
+                {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(mismatches, 0u);
+}
+
+TEST(KeyValuePairExtractorTests, ExtractIntoExistingResponse) {
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    KeyValuePairExtractor::Response response;
+
+    extractor->extract("name:neymar age:31 team:psg", response);
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"name", "neymar"}, {"age", "31"}, {"team", "psg"}}));
+
+    // Fewer pairs, a duplicated key and a key that was not there before
+    extractor->extract("name:messi name:ronaldo, nationality:portugal", response);
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"name", "ronaldo"}, {"nationality", "portugal"}}));
+
+    extractor->extract("", response);
+    EXPECT_TRUE(response.empty());
+}
+
+TEST(KeyValuePairExtractorTests, InternKeysAcrossRows) {
+    auto dictionary = std::make_shared<extractKV::KeyDictionary>(2);
+    auto extractor = KeyValuePairExtractorBuilder().withKeyDictionary(dictionary).build();
+
+    KeyValuePairExtractor::InternedResponse response;
+
+    extractor->extract("name:neymar age:31 name:messi", response);
+    ASSERT_EQ(response.pairs.size(), 2u);
+    EXPECT_EQ(dictionary->key(response.pairs[0].first), "name");
+    EXPECT_EQ(response.pairs[0].second, "messi");
+    EXPECT_EQ(dictionary->key(response.pairs[1].first), "age");
+    EXPECT_EQ(response.pairs[1].second, "31");
+    EXPECT_TRUE(response.overflow.empty());
+
+    // Ids are stable across rows, keys past the dictionary capacity end up in the overflow map
+    const auto name_id = response.pairs[0].first;
+
+    extractor->extract("team:psg name:ronaldo", response);
+    ASSERT_EQ(response.pairs.size(), 1u);
+    EXPECT_EQ(response.pairs[0].first, name_id);
+    EXPECT_EQ(response.pairs[0].second, "ronaldo");
+    EXPECT_EQ(response.overflow, (KeyValuePairExtractor::Response {{"team", "psg"}}));
+    EXPECT_EQ(dictionary->size(), 2u);
+
+    // Value strings of a shorter row are set aside and reused by the next longer one
+    extractor->extract("name:a_value_longer_than_the_small_string_buffer age:another_value_longer_than_that", response);
+    const auto * age_data = response.pairs[1].second.data();
+
+    extractor->extract("name:short", response);
+    ASSERT_EQ(response.pairs.size(), 1u);
+    EXPECT_EQ(response.spare_values.size(), 1u);
+
+    extractor->extract("name:x age:the_age_value_is_long_as_well", response);
+    ASSERT_EQ(response.pairs.size(), 2u);
+    EXPECT_EQ(response.pairs[1].second, "the_age_value_is_long_as_well");
+    EXPECT_EQ(response.pairs[1].second.data(), age_data);
+    EXPECT_TRUE(response.spare_values.empty());
+
+    EXPECT_THROW(KeyValuePairExtractorBuilder().build()->extract("a:b", response), std::runtime_error);
+}
+
+TEST(KeyValuePairExtractorTests, IncrementalKeyHashMatchesOneShot) {
+    const std::string key = "a_key_that_spans_a_few_words";
+
+    for (size_t first = 0; first <= key.size(); ++first)
+    {
+        for (size_t second = first; second <= key.size(); ++second)
+        {
+            KeyHash::Hasher hasher;
+            hasher.update(std::string_view(key).substr(0, first));
+            hasher.update(std::string_view(key).substr(first, second - first));
+            hasher.update(std::string_view(key).substr(second));
+
+            EXPECT_EQ(hasher.finalize(), KeyHash::hash(key));
+        }
+    }
+
+    // Keys with escape sequences are hashed chunk by chunk while being read
+    auto dictionary = std::make_shared<extractKV::KeyDictionary>();
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().withKeyDictionary(dictionary).build();
+
+    KeyValuePairExtractor::InternedResponse response;
+    extractor->extract(R"(long_\x41_key_with_escapes:1 "quoted\nkey":2)", response);
+
+    ASSERT_EQ(response.pairs.size(), 2u);
+    EXPECT_EQ(dictionary->find("long_A_key_with_escapes"), response.pairs[0].first);
+    EXPECT_EQ(dictionary->find("quoted\nkey"), response.pairs[1].first);
+}
+
+TEST(KeyValuePairExtractorTests, CalibratedSearchSymbolsMatchDefaultKernel) {
+    const std::string all_needles = ":=, ;\"\\\t|&!#%*+/";
+    ASSERT_EQ(all_needles.size(), static_cast<size_t>(SearchSymbols::BUFFER_SIZE));
+
+    // Matches at irregular distances, shorter and longer than a SIMD register
+    std::string haystack;
+
+    for (size_t i = 0; i < 400; ++i)
+    {
+        haystack.push_back(i % 37 == 0 || i % 11 == 3 ? all_needles[(i * 7) % all_needles.size()] : static_cast<char>('a' + i % 26));
+    }
+
+    for (size_t num_chars = 1; num_chars <= all_needles.size(); ++num_chars)
+    {
+        const auto needles = all_needles.substr(0, num_chars);
+        const auto calibrated = SearchSymbolsCalibration::calibrate(needles);
+        EXPECT_EQ(calibrated.kernel, SearchSymbolsCalibration::fastestKernel(num_chars));
+
+        // The SSE 4.2 kernel is available without compiling for SSE 4.2, as long as the CPU has it
+        EXPECT_EQ(SearchSymbols(needles, SearchSymbols::Kernel::SSE42).kernel,
+                  SearchSymbols::hasSSE42() ? SearchSymbols::Kernel::SSE42 : SearchSymbols::Kernel::SSE2);
+
+        // Whichever kernel the calibration picks, it finds the same positions as the others
+        for (const SearchSymbols & other : {SearchSymbols {needles}, SearchSymbols {needles, SearchSymbols::Kernel::SSE2},
+                                            SearchSymbols {needles, SearchSymbols::Kernel::SSE42}})
+        {
+            for (size_t begin = 0; begin < haystack.size(); ++begin)
+            {
+                const std::string_view rest {haystack.data() + begin, haystack.size() - begin};
+
+                EXPECT_EQ(find_first_symbols(rest, calibrated), find_first_symbols(rest, other));
+                EXPECT_EQ(find_first_symbols_or_null(rest, calibrated), find_first_symbols_or_null(rest, other));
+                EXPECT_EQ(find_first_not_symbols_or_null(rest, calibrated), find_first_not_symbols_or_null(rest, other));
+            }
+        }
+    }
+}
+
+TEST(KeyValuePairExtractorTests, ByteClassesMatchNeedles) {
+    using enum extractKV::ByteClassTable::Class;
+
+    auto check = [](const extractKV::Configuration & configuration, auto with_escaping)
+    {
+        extractKV::NeedleFactory<with_escaping> factory;
+        const extractKV::ByteClassTable byte_classes(configuration, with_escaping);
+        const uint8_t escape = with_escaping ? ESCAPE_CHARACTER : REGULAR;
+
+        const std::vector<std::pair<SearchSymbols, uint8_t>> needles_and_classes {
+            {factory.getWaitNeedles(configuration), KEY_VALUE_DELIMITER | PAIR_DELIMITER | escape},
+            {factory.getReadKeyNeedles(configuration), KEY_VALUE_DELIMITER | QUOTING_CHARACTER | PAIR_DELIMITER | escape},
+            {factory.getReadValueNeedles(configuration), QUOTING_CHARACTER | PAIR_DELIMITER | escape},
+            {factory.getReadQuotedNeedles(configuration), QUOTING_CHARACTER | escape}
+        };
+
+        for (const auto & [needles, classes] : needles_and_classes)
+        {
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                const auto character = static_cast<char>(byte);
+                EXPECT_EQ(byte_classes.is(character, classes), needles.str.find(character) != std::string::npos) << byte;
+            }
+        }
+    };
+
+    check(extractKV::ConfigurationFactory::createWithoutEscaping(':', '"', {' ', ','}), std::false_type {});
+    check(extractKV::ConfigurationFactory::createWithEscaping(':', '"', {' ', ','}), std::true_type {});
+    check(extractKV::ConfigurationFactory::createWithEscaping('=', '\'', {'&', ';', '\t', '\xFF'}), std::true_type {});
+}
+
+TEST(KeyValuePairExtractorTests, AdaptiveSymbolSearchMatchesFindFirstSymbols) {
+    const auto configuration = extractKV::ConfigurationFactory::createWithoutEscaping('=', '"', {' '});
+    const extractKV::ByteClassTable byte_classes(configuration, false);
+    const auto classes = extractKV::ByteClassTable::KEY_VALUE_DELIMITER | extractKV::ByteClassTable::PAIR_DELIMITER;
+    const auto needles = extractKV::NeedleFactory<false>().getWaitNeedles(configuration);
+
+    // Short tokens keep the search on the table, long ones switch it to SIMD and back, some span the scalar scan limit
+    std::string input;
+
+    for (size_t token_length : {1, 2, 1, 3, 2, 1, 1, 2, 15, 16, 17, 40, 64, 300, 100, 90, 1, 2, 1, 1, 1, 2, 3, 1, 1, 1, 1, 1, 20, 1})
+    {
+        for (size_t repetition = 0; repetition < 4; ++repetition)
+        {
+            input.append(token_length, 'x');
+            input.push_back(repetition % 2 ? ' ' : '=');
+        }
+    }
+
+    input.append(33, 'x');
+
+    extractKV::AdaptiveSymbolSearch search(byte_classes);
+
+    for (size_t position = 0; position < input.size();)
+    {
+        const std::string_view rest {input.data() + position, input.size() - position};
+        const auto * found = search.findFirstSymbolOrNull(rest, needles, classes);
+
+        ASSERT_EQ(found, find_first_symbols_or_null(rest, needles)) << position;
+
+        if (!found)
+        {
+            break;
+        }
+
+        const std::string_view after {found + 1, input.data() + input.size()};
+        EXPECT_EQ(search.findFirstNotSymbolOrNull(after, needles, classes), find_first_not_symbols_or_null(after, needles)) << position;
+
+        position = found - input.data() + 1;
+    }
+}
+
+TEST(KeyValuePairExtractorTests, RowShapeFastPath) {
+    auto builder = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').withEscaping();
+    auto extractor = builder.build();
+    auto handle = builder.buildHandleWithEscaping();
+
+    // Remembered keys are checked against the input, rows of a different shape are extracted as usual
+    const std::vector<std::string> rows {
+        "ts=1 level=info msg=\"hello\" latency=0",
+        "ts=2 level=info msg=\"hello\" latency=1",
+        "ts=3 level=warn msg=\"hello\" latency=2",
+        "ts=4 level_name=info \"msg\"=hi lat\\x41ency=3",
+        "ts=5 lev=el=x"
+    };
+
+    for (const auto & row : rows)
+    {
+        EXPECT_EQ(handle.extract(row), extractor->extract(row));
+    }
+
+    EXPECT_EQ(handle.getRowShape().hits(), 10u);
+    EXPECT_EQ(handle.getRowShape().checks(), 12u);
+}
+
+TEST(KeyValuePairExtractorTests, ExtractSingleValue) {
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    const std::string data = R"(id:1 xid:2 value:id:3, id:4 message:"id:5 \"quoted\"" id:"6" x\x41:7)";
+
+    EXPECT_EQ(extractor->extractValue(data, "xid"), "2");
+    EXPECT_EQ(extractor->extractValue(data, "value"), "id:3");
+    EXPECT_EQ(extractor->extractValue(data, "message"), "id:5 \"quoted\"");
+    EXPECT_EQ(extractor->extractValue(data, "xA"), "7");
+    EXPECT_EQ(extractor->extractValue(data, "missing"), std::nullopt);
+
+    // Last occurrence wins, occurrences inside values and quotes are not keys
+    EXPECT_EQ(extractor->extractValue(data, "id"), "6");
+    EXPECT_EQ(extractor->extractValue("id:1 value:id:3", "id"), "1");
+    EXPECT_EQ(extractor->extractValue("id:1 message:\"id:5\"", "id"), "1");
+}
+
+TEST(KeyValuePairExtractorTests, FilterRows) {
+    auto extractor = KeyValuePairExtractorBuilder().withKeyValueDelimiter('=').withFilter("level=ERROR").withFilter("status!=200").withFilter("!debug").build();
+
+    KeyValuePairExtractor::Response response;
+
+    EXPECT_TRUE(extractor->extract("level=ERROR status=500 msg=boom", response));
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"level", "ERROR"}, {"status", "500"}, {"msg", "boom"}}));
+
+    EXPECT_TRUE(extractor->extract("msg=no_status level=ERROR", response));
+    EXPECT_EQ(response.size(), 2u);
+
+    EXPECT_FALSE(extractor->extract("level=INFO status=500 msg=boom", response));
+    EXPECT_TRUE(response.empty());
+
+    EXPECT_FALSE(extractor->extract("level=ERROR status=200", response));
+    EXPECT_FALSE(extractor->extract("level=ERROR debug=1", response));
+    EXPECT_FALSE(extractor->extract("status=500 msg=missing_level", response));
+
+    // Decided by the first occurrence of a key, the row stops there, while the output keeps the last value
+    EXPECT_FALSE(extractor->extract("level=INFO level=ERROR", response));
+    EXPECT_TRUE(response.empty());
+
+    EXPECT_TRUE(extractor->extract("level=ERROR level=INFO", response));
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"level", "INFO"}}));
+
+    EXPECT_FALSE(extractor->extract("level=ERROR status=200 status=500", response));
+    EXPECT_TRUE(extractor->extract("level=ERROR status=500 status=200", response));
+
+    EXPECT_THROW(KeyValuePairExtractorBuilder().withFilter("=value"), std::runtime_error);
+}
+
+TEST(KeyValuePairExtractorTests, ValidateCountsPairsAndReportsMalformedRegions) {
+    using Discard = KeyValuePairExtractor::ValidationResult::Discard;
+
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    KeyValuePairExtractor::ValidationResult result;
+
+    extractor->validate(R"(a:1 a:2 bad,key:3 "":4 v:\q c:"unterminated)", result);
+
+    // The duplicated key is counted, the empty quoted key makes `4` a key of its own
+    EXPECT_EQ(result.number_of_pairs, 3u);
+
+    const std::vector<std::tuple<Discard, size_t, size_t>> expected_regions {
+        {Discard::PAIR_DELIMITER_IN_KEY, 8, 12},
+        {Discard::EMPTY_QUOTED_KEY, 19, 20},
+        {Discard::PAIR_DELIMITER_IN_KEY, 21, 23},
+        {Discard::ESCAPE_CHARACTER_AT_VALUE_START, 25, 25},
+        {Discard::PAIR_DELIMITER_IN_KEY, 26, 28},
+        {Discard::UNTERMINATED_QUOTE, 31, 43}
+    };
+
+    ASSERT_EQ(result.malformed_regions.size(), expected_regions.size());
+
+    for (size_t i = 0; i < expected_regions.size(); ++i)
+    {
+        const auto & region = result.malformed_regions[i];
+        EXPECT_EQ(std::make_tuple(region.reason, region.begin, region.end), expected_regions[i]);
+    }
+
+    extractor->validate("a:1", result);
+    EXPECT_EQ(result.number_of_pairs, 1u);
+    EXPECT_TRUE(result.malformed_regions.empty());
+}
+
+TEST(KeyValuePairExtractorTests, LimitPolicies) {
+    using Policy = extractKV::Limits::Policy;
+    using Response = KeyValuePairExtractor::Response;
+
+    const std::string input = "a:1 long_key:2 b:long_value c:3";
+
+    auto extract = [&](KeyValuePairExtractorBuilder builder)
+    {
+        return builder.build()->extract(input);
+    };
+
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxKeyLength(4, Policy::TRUNCATE)),
+              (Response {{"a", "1"}, {"long", "2"}, {"b", "long_value"}, {"c", "3"}}));
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxKeyLength(4, Policy::SKIP_PAIR)),
+              (Response {{"a", "1"}, {"b", "long_value"}, {"c", "3"}}));
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxKeyLength(4, Policy::STOP_ROW)), (Response {{"a", "1"}}));
+    EXPECT_THROW(extract(KeyValuePairExtractorBuilder().withMaxKeyLength(4)), std::runtime_error);
+
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxValueLength(4, Policy::TRUNCATE)),
+              (Response {{"a", "1"}, {"long_key", "2"}, {"b", "long"}, {"c", "3"}}));
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxValueLength(4, Policy::SKIP_PAIR)),
+              (Response {{"a", "1"}, {"long_key", "2"}, {"c", "3"}}));
+
+    // Skipped pairs don't count towards the output size
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxOutputBytes(13, Policy::SKIP_PAIR)),
+              (Response {{"a", "1"}, {"long_key", "2"}, {"c", "3"}}));
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxOutputBytes(13, Policy::STOP_ROW)),
+              (Response {{"a", "1"}, {"long_key", "2"}}));
+
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxNumberOfPairs(2, Policy::TRUNCATE)),
+              (Response {{"a", "1"}, {"long_key", "2"}}));
+    EXPECT_THROW(extract(KeyValuePairExtractorBuilder().withMaxNumberOfPairs(2)), std::runtime_error);
+    EXPECT_EQ(extract(KeyValuePairExtractorBuilder().withMaxNumberOfPairs(4)).size(), 4u);
+
+    // Truncated keys are interned as truncated
+    auto dictionary = std::make_shared<extractKV::KeyDictionary>();
+    auto interning_extractor = KeyValuePairExtractorBuilder().withKeyDictionary(dictionary).withMaxKeyLength(4, Policy::TRUNCATE).build();
+
+    KeyValuePairExtractor::InternedResponse interned;
+    interning_extractor->extract(input, interned);
+
+    EXPECT_EQ(dictionary->find("long"), interned.pairs[1].first);
+}
+
+TEST(KeyValuePairExtractorTests, TryExtractReturnsErrors) {
+    using Code = KeyValuePairExtractor::ExtractionError::Code;
+
+    auto extractor = KeyValuePairExtractorBuilder().withMaxNumberOfPairs(2).build();
+
+    KeyValuePairExtractor::Response response;
+
+    auto result = extractor->tryExtract("a:1 b:2 c:3 d:4", response);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().code, Code::NUMBER_OF_PAIRS_LIMIT);
+    EXPECT_EQ(result.error().offset, 12u);
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"a", "1"}, {"b", "2"}}));
+
+    result = extractor->tryExtract("a:1 b:2", response);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result.value());
+
+    auto value_limited = KeyValuePairExtractorBuilder().withMaxValueLength(3).buildHandleWithEscaping();
+
+    auto handle_result = value_limited.tryExtract("a:\\x41 b:long_value c:3");
+    ASSERT_FALSE(handle_result.has_value());
+    EXPECT_EQ(handle_result.error().code, Code::VALUE_LENGTH_LIMIT);
+    EXPECT_EQ(handle_result.error().offset, 20u);
+
+    EXPECT_EQ(value_limited.tryExtract("a:v\\x41 b:\\q").value().get(), (KeyValuePairExtractor::Response {{"a", "vA"}}));
+}
+
+TEST(KeyValuePairExtractorTests, DiagnosticsRecordDiscardedTokens) {
+    using Discard = extractKV::Diagnostics::Discard;
+
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    extractKV::Diagnostics diagnostics(4, 2);
+    KeyValuePairExtractor::Response response;
+
+    extractor->extract("a:1 bad,key:2 c:\"open", response, diagnostics);
+    EXPECT_EQ(response, (KeyValuePairExtractor::Response {{"a", "1"}, {"key", "2"}}));
+
+    auto events = diagnostics.events();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].reason, Discard::PAIR_DELIMITER_IN_KEY);
+    EXPECT_EQ(std::make_tuple(events[0].row, events[0].begin, events[0].end), std::make_tuple(0u, 4u, 8u));
+    EXPECT_EQ(events[1].reason, Discard::UNTERMINATED_QUOTE);
+    EXPECT_EQ(diagnostics.samples()[0].snippet, "bad,");
+    EXPECT_EQ(diagnostics.samples()[1].snippet, "open");
+
+    // Memory stays bounded, counters cover every event
+    for (size_t i = 0; i < 100; ++i)
+    {
+        extractor->extract("x,y:1", response, diagnostics);
+    }
+
+    events = diagnostics.events();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events.back().row, 100u);
+    EXPECT_EQ(diagnostics.samples().size(), 2u);
+    EXPECT_EQ(diagnostics.count(Discard::PAIR_DELIMITER_IN_KEY), 101u);
+    EXPECT_EQ(diagnostics.numberOfEvents(), 102u);
+    EXPECT_EQ(diagnostics.numberOfRows(), 101u);
+
+    // Snippet strings, here longer than the small string buffer, are kept for the samples after `clear()`
+    diagnostics.clear();
+    extractor->extract("a_long_key_with_a,comma:1", response, diagnostics);
+    const auto * snippet_data = diagnostics.samples()[0].snippet.data();
+
+    diagnostics.clear();
+    EXPECT_TRUE(diagnostics.samples().empty());
+    EXPECT_EQ(diagnostics.numberOfEvents(), 0u);
+
+    extractor->extract("another_long_key,comma:1", response, diagnostics);
+    ASSERT_EQ(diagnostics.samples().size(), 1u);
+    EXPECT_EQ(diagnostics.samples()[0].snippet, "another_long_key,");
+    EXPECT_EQ(diagnostics.samples()[0].snippet.data(), snippet_data);
+}
+
+TEST(KeyValuePairExtractorTests, PmrResponseAllocatesFromResource) {
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    KeyValuePairExtractor::PmrResponse response(&arena);
+
+    // Long enough to defeat the small string optimization. Both the upstream and the default resource throw, so any pmr allocation
+    // outside of the arena, e.g. by the escaping writer, fails the test.
+    const std::string long_value(100, 'v');
+    const std::string input = "key_with_a_rather_long_name:\"" + long_value + "\\x41\" b:2";
+
+    auto * default_resource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    EXPECT_NO_THROW(EXPECT_TRUE(extractor->extract(input, response)));
+    std::pmr::set_default_resource(default_resource);
+
+    ASSERT_EQ(response.size(), 2u);
+    EXPECT_EQ(std::string_view(response.at("key_with_a_rather_long_name")), long_value + "A");
+    EXPECT_EQ(std::string_view(response.at("b")), "2");
+    EXPECT_EQ(response.at("b").get_allocator().resource(), &arena);
+}
+
+TEST(KeyValuePairExtractorTests, CountAllocationsPerExtraction) {
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    extractKV::CountingMemoryResource counting_resource;
+    const std::string input = "a_key_longer_than_sso_buffers:\"a value longer than the sso buffer\" b:2";
+
+    {
+        KeyValuePairExtractor::PmrResponse response(&counting_resource);
+        extractor->extract(input, response);
+
+        const auto & stats = counting_resource.getStats();
+        EXPECT_GT(stats.allocations, 0u);
+        EXPECT_GE(stats.bytes_allocated, stats.peak_live_bytes);
+        EXPECT_GE(stats.peak_live_bytes, stats.live_bytes);
+        EXPECT_GT(stats.live_bytes, 0u);
+
+        // Refilling the same response reuses its nodes and strings
+        counting_resource.resetStats();
+        extractor->extract(input, response);
+        EXPECT_EQ(counting_resource.getStats().allocations, counting_resource.getStats().deallocations);
+    }
+
+    EXPECT_EQ(counting_resource.getStats().live_bytes, 0u);
+}
+
+TEST(KeyValuePairExtractorTests, LatencyHistogram) {
+    using Histogram = extractKV::LatencyHistogram;
+
+    for (uint64_t value : {0ull, 15ull, 16ull, 31ull, 32ull, 1000ull, 123456789ull, ~0ull})
+    {
+        const auto bucket = Histogram::bucketOf(value);
+        ASSERT_LT(bucket, Histogram::NUMBER_OF_BUCKETS);
+        EXPECT_LE(Histogram::bucketLowerBound(bucket), value);
+        EXPECT_GE(Histogram::bucketUpperBound(bucket), value);
+    }
+
+    Histogram histogram;
+
+    for (uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count(), 1000u);
+    EXPECT_NEAR(snapshot.percentile(0.5), 500, 500 / Histogram::SUB_BUCKETS);
+    EXPECT_NEAR(snapshot.percentile(0.99), 990, 990 / Histogram::SUB_BUCKETS);
+    EXPECT_EQ(snapshot.percentile(1.0), Histogram::bucketUpperBound(Histogram::bucketOf(1000)));
+
+    snapshot.merge(snapshot);
+    EXPECT_EQ(snapshot.count(), 2000u);
+    EXPECT_NEAR(snapshot.percentile(0.5), 500, 500 / Histogram::SUB_BUCKETS);
+
+    // Every extraction is recorded, from any thread
+    auto latencies = std::make_shared<Histogram>();
+    auto extractor = KeyValuePairExtractorBuilder().withLatencyHistogram(latencies).build();
+
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            for (size_t j = 0; j < 100; ++j)
+            {
+                extractor->extract("a:1 b:2");
+            }
+        });
+    }
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(latencies->snapshot().count(), 400u);
+    EXPECT_GT(latencies->snapshot().percentile(0.999), 0u);
+
+    latencies->reset();
+    EXPECT_EQ(latencies->snapshot().count(), 0u);
+}
+
+TEST(KeyValuePairExtractorTests, StreamRecordsToNdjson) {
+    const auto path = ::testing::TempDir() + "records.txt";
+    std::ofstream(path) << "a:1 b:2\nlong_key:\"quoted \\\"value\\\"\"\n\nc:3";
+
+    auto extractor = KeyValuePairExtractorBuilder().withEscaping().build();
+
+    // A 4 byte buffer, so that most records straddle its end
+    ReadBufferFromFile in(path, 4);
+    RecordReader reader(in, '\n');
+    WriteBufferFromString out(1);
+
+    std::string_view record;
+    std::vector<std::string> records;
+    KeyValuePairExtractor::Response response;
+
+    while (reader.next(record))
+    {
+        records.emplace_back(record);
+
+        extractor->extract(record, response);
+        extractKV::NdjsonSerializer::writeRow(std::map(response.begin(), response.end()), out);
+    }
+
+    EXPECT_EQ(records, (std::vector<std::string> {"a:1 b:2", "long_key:\"quoted \\\"value\\\"\"", "", "c:3"}));
+    EXPECT_EQ(out.str(), "{\"a\":\"1\",\"b\":\"2\"}\n{\"long_key\":\"quoted \\\"value\\\"\"}\n{}\n{\"c\":\"3\"}\n");
+
+    WriteBufferFromString escaped;
+    extractKV::NdjsonSerializer::writeString("tab\t\x01\"\\", escaped);
+    EXPECT_EQ(escaped.str(), "\"tab\\t\\u0001\\\"\\\\\"");
+}
+
+TEST(KeyValuePairExtractorTests, RejectRecordsOverLimitsInStream) {
+    const auto path = ::testing::TempDir() + "records_over_limit.txt";
+    std::ofstream(path) << "a:1 b:2\na:3 b:4 c:5 d:6\na:7\n";
+
+    auto extractor = KeyValuePairExtractorBuilder().withMaxNumberOfPairs(2).build();
+
+    auto for_each_record = [&](auto && callback)
+    {
+        ReadBufferFromFile in(path, 4);
+        RecordReader reader(in, '\n');
+        std::string_view record;
+
+        while (reader.next(record))
+        {
+            callback(record);
+        }
+    };
+
+    // The corrupted record is reported, the records after it are extracted as usual
+    std::vector<KeyValuePairExtractor::Response> rows;
+    size_t rejected = 0;
+    KeyValuePairExtractor::Response response;
+
+    for_each_record([&](std::string_view record)
+    {
+        if (extractor->tryExtract(record, response))
+        {
+            rows.push_back(response);
+        }
+        else
+        {
+            ++rejected;
+        }
+    });
+
+    EXPECT_EQ(rejected, 1u);
+    EXPECT_EQ(rows, (std::vector<KeyValuePairExtractor::Response> {{{"a", "1"}, {"b", "2"}}, {{"a", "7"}}}));
+
+    // A rejected record leaves no partial row in a batch
+    extractKV::ColumnarBatch batch({"a", "b"});
+    std::vector<bool> failed;
+
+    for_each_record([&](std::string_view record)
+    {
+        failed.push_back(!extractor->tryExtract(record, batch).has_value());
+    });
+
+    EXPECT_EQ(failed, (std::vector<bool> {false, true, false}));
+    ASSERT_EQ(batch.numberOfRows(), 2u);
+    EXPECT_EQ(batch.getColumn(0).value(0), "1");
+    EXPECT_EQ(batch.getColumn(0).value(1), "7");
+    EXPECT_TRUE(batch.getColumn(1).isNull(1));
+
+    EXPECT_THROW(extractor->extract("a:3 b:4 c:5", batch), std::runtime_error);
+    EXPECT_EQ(batch.numberOfRows(), 2u);
+    EXPECT_EQ(batch.getColumn(0).offsets.size(), 3u);
+}
+
+TEST(KeyValuePairExtractorTests, SerializeRows) {
+    const std::map<std::string, std::string> row {{"a", "plain"}, {"b", "with,comma"}, {"c", "say \"hi\"\tthen\nbye"}, {"d", ""}};
+
+    WriteBufferFromString csv;
+    extractKV::CsvSerializer csv_serializer({"c", "b", "missing", "a"});
+    csv_serializer.writeHeader(csv);
+    csv_serializer.writeRow(row, csv);
+    EXPECT_EQ(csv.str(), "c,b,missing,a\n\"say \"\"hi\"\"\tthen\nbye\",\"with,comma\",,plain\n");
+
+    WriteBufferFromString tsv;
+    extractKV::TsvSerializer tsv_serializer({"c", "a"});
+    tsv_serializer.writeRow(row, tsv);
+    EXPECT_EQ(tsv.str(), "say \"hi\"\\tthen\\nbye\tplain\n");
+
+    WriteBufferFromString logfmt;
+    extractKV::LogfmtSerializer::writeRow(row, logfmt);
+    EXPECT_EQ(logfmt.str(), "a=plain b=with,comma c=\"say \\\"hi\\\"\\tthen\\nbye\" d=\"\"\n");
+
+    // The vectorized search agrees with a byte by byte scan, wherever the byte to escape is
+    for (size_t size = 0; size < 40; ++size)
+    {
+        for (size_t position = 0; position <= size; ++position)
+        {
+            for (char special : {'"', '\\', '\0', '\x1F'})
+            {
+                std::string s(size, '\x80');
+                if (position < size)
+                {
+                    s[position] = special;
+                }
+
+                const auto * found = find_first_symbols_or_control<'"', '\\'>(s.data(), s.data() + s.size());
+                EXPECT_EQ(found, s.data() + position);
+            }
+        }
+    }
+}
+
+TEST(KeyValuePairExtractorTests, ColumnarBatchAndArrowStream) {
+    auto extractor = KeyValuePairExtractorBuilder().withFilter("!drop").build();
+
+    const std::vector<std::string> rows {"a:1 b:2", "a:3 drop:yes", "c:x a:4 a:5", ""};
+
+    // Map layout: every pair of each row, a duplicated key keeps its last value at its last position
+    extractKV::ColumnarBatch map_batch;
+
+    for (const auto & row : rows)
+    {
+        extractor->extract(row, map_batch);
+    }
+
+    ASSERT_EQ(map_batch.numberOfRows(), 3u);
+    EXPECT_EQ(map_batch.getMapOffsets(), (std::vector<int32_t> {0, 2, 4, 4}));
+    EXPECT_EQ(map_batch.getKeys().data, "abca");
+    EXPECT_EQ(map_batch.getValues().data, "12x5");
+
+    // Projected layout: one nullable column per key
+    extractKV::ColumnarBatch projected_batch({"a", "c"});
+
+    for (const auto & row : rows)
+    {
+        extractor->extract(row, projected_batch);
+    }
+
+    ASSERT_EQ(projected_batch.numberOfRows(), 3u);
+    const auto & a = projected_batch.getColumn(0);
+    const auto & c = projected_batch.getColumn(1);
+    EXPECT_EQ(a.value(0), "1");
+    EXPECT_EQ(a.value(1), "5");
+    EXPECT_TRUE(a.isNull(2));
+    EXPECT_EQ(a.null_count, 1u);
+    EXPECT_TRUE(c.isNull(0));
+    EXPECT_EQ(c.value(1), "x");
+    EXPECT_EQ(c.null_count, 2u);
+
+    // The stream is a schema message, one record batch message per batch and the end of stream marker. Each message is framed as
+    // continuation marker, metadata length, FlatBuffers `Message` and a body of `Message.bodyLength` bytes.
+    WriteBufferFromString out;
+    extractKV::ArrowStreamWriter writer(out);
+    writer.write(projected_batch);
+    writer.write(projected_batch);
+    writer.finish(projected_batch);
+
+    const auto stream = out.str();
+
+    auto read = [&](size_t position, auto value)
+    {
+        memcpy(&value, stream.data() + position, sizeof(value));
+        return value;
+    };
+
+    std::vector<int> header_types;
+    size_t position = 0;
+
+    while (true)
+    {
+        ASSERT_EQ(position % 8, 0u);
+        ASSERT_EQ(read(position, uint32_t {}), 0xFFFFFFFF);
+
+        const auto metadata_length = read(position + 4, int32_t {});
+        position += 8;
+
+        if (metadata_length == 0)
+        {
+            break;
+        }
+
+        // Root table, its vtable, then the `header_type` (id 1) and `bodyLength` (id 3) fields
+        const auto table = position + read(position, uint32_t {});
+        const auto vtable = table - read(table, int32_t {});
+        header_types.push_back(read(table + read(vtable + 4 + 2 * 1, uint16_t {}), uint8_t {}));
+        const auto body_length = read(table + read(vtable + 4 + 2 * 3, uint16_t {}), int64_t {});
+
+        position += metadata_length + body_length;
+    }
+
+    EXPECT_EQ(position, stream.size());
+    EXPECT_EQ(header_types, (std::vector<int> {1, 3, 3}));
+}
+
+TEST(KeyValuePairExtractorTests, DictionaryEncodedColumns) {
+    using Encoding = extractKV::ColumnarBatch::Encoding;
+
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    auto value_of = [](const extractKV::ColumnarBatch & batch, size_t column_index, size_t row) -> std::optional<std::string>
+    {
+        if (batch.getEncoding(column_index) == Encoding::PLAIN)
+        {
+            const auto & column = batch.getColumn(column_index);
+            return column.isNull(row) ? std::nullopt : std::optional<std::string>(column.value(row));
+        }
+
+        const auto & column = batch.getDictionaryColumn(column_index);
+
+        if (column.null_count && !(column.validity[row / 8] & (1u << (row % 8))))
+        {
+            return std::nullopt;
+        }
+
+        const auto index = batch.getEncoding(column_index) == Encoding::DICTIONARY_UINT8
+            ? column.indices[row]
+            : column.indices[row * 2] | (column.indices[row * 2 + 1] << 8);
+
+        return std::string(column.dictionary.getValues().value(index));
+    };
+
+    // Repeated values are stored once, a missing or repeated key works like in plain columns
+    extractKV::ColumnarBatch batch({"level", "id"}, {"level"});
+
+    for (const auto * row : {"level:info id:1", "level:warn id:2", "id:3", "level:info level:warn", "level:info id:5"})
+    {
+        extractor->extract(row, batch);
+    }
+
+    ASSERT_EQ(batch.getEncoding(0), Encoding::DICTIONARY_UINT8);
+    EXPECT_EQ(batch.getEncoding(1), Encoding::PLAIN);
+    EXPECT_EQ(batch.getDictionaryColumn(0).dictionary.size(), 2u);
+    EXPECT_EQ(batch.getDictionaryColumn(0).null_count, 1u);
+
+    const std::vector<std::optional<std::string>> levels {"info", "warn", std::nullopt, "warn", "info"};
+
+    for (size_t row = 0; row < levels.size(); ++row)
+    {
+        EXPECT_EQ(value_of(batch, 0, row), levels[row]);
+    }
+
+    // More than 256 distinct values widen the indices, more than `max_dictionary_size` fall back to plain strings
+    extractKV::ColumnarBatch widened({"a", "b"}, {"a", "b"}, 400);
+
+    for (size_t i = 0; i < 600; ++i)
+    {
+        extractor->extract("a:" + std::to_string(i % 300) + " b:" + std::to_string(i), widened);
+    }
+
+    EXPECT_EQ(widened.getEncoding(0), Encoding::DICTIONARY_UINT16);
+    EXPECT_EQ(widened.getEncoding(1), Encoding::PLAIN);
+
+    for (size_t row = 0; row < 600; ++row)
+    {
+        EXPECT_EQ(value_of(widened, 0, row), std::to_string(row % 300));
+        EXPECT_EQ(value_of(widened, 1, row), std::to_string(row));
+    }
+
+    // The encoding is fixed after the first batch, a full dictionary asks for the batch to be written
+    widened.clear();
+    EXPECT_EQ(widened.getEncoding(0), Encoding::DICTIONARY_UINT16);
+    EXPECT_FALSE(widened.isFull());
+
+    extractKV::ColumnarBatch frozen({"a"}, {"a"});
+    extractor->extract("a:x", frozen);
+    frozen.clear();
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        extractor->extract("a:" + std::to_string(i), frozen);
+    }
+
+    EXPECT_EQ(frozen.getEncoding(0), Encoding::DICTIONARY_UINT8);
+    EXPECT_TRUE(frozen.isFull());
+    EXPECT_THROW(extractor->extract("a:new", frozen), std::runtime_error);
+    EXPECT_EQ(frozen.numberOfRows(), 256u);
+    EXPECT_EQ(frozen.getDictionaryColumn(0).dictionary.size(), 256u);
+
+    // Only the last value of a repeated key is added, a row that doesn't fit leaves every column as it was
+    extractKV::ColumnarBatch repeated({"x", "level"}, {"level"});
+    extractor->extract("level:a", repeated);
+    repeated.clear();
+
+    for (size_t i = 0; i < 255; ++i)
+    {
+        extractor->extract("level:" + std::to_string(i) + " x:1", repeated);
+    }
+
+    EXPECT_FALSE(repeated.isFull());
+    extractor->extract("level:dup1 level:dup2 x:2", repeated);
+
+    EXPECT_TRUE(repeated.isFull());
+    EXPECT_EQ(repeated.numberOfRows(), 256u);
+    EXPECT_EQ(repeated.getColumn(0).offsets.size(), 257u);
+    EXPECT_EQ(repeated.getDictionaryColumn(1).dictionary.size(), 256u);
+    EXPECT_EQ(value_of(repeated, 1, 255), "dup2");
+
+    EXPECT_THROW(extractor->extract("x:3 level:new", repeated), std::runtime_error);
+    EXPECT_EQ(repeated.numberOfRows(), 256u);
+    EXPECT_EQ(repeated.getColumn(0).offsets.size(), 257u);
+    EXPECT_EQ(repeated.getColumn(0).data.size(), 256u);
+
+    extractor->extract("x:4 level:dup2", repeated);
+    EXPECT_EQ(repeated.numberOfRows(), 257u);
+    EXPECT_EQ(value_of(repeated, 0, 256), "4");
+    EXPECT_EQ(value_of(repeated, 1, 256), "dup2");
+
+    EXPECT_THROW(extractKV::ColumnarBatch({"a"}, {"b"}), std::runtime_error);
+
+    // Each record batch is preceded by a dictionary batch per dictionary encoded column
+    WriteBufferFromString out;
+    extractKV::ArrowStreamWriter writer(out);
+    writer.write(batch);
+    writer.write(batch);
+    writer.finish(batch);
+
+    const auto stream = out.str();
+    std::vector<int> header_types;
+
+    for (size_t position = 0;;)
+    {
+        int32_t metadata_length;
+        memcpy(&metadata_length, stream.data() + position + 4, sizeof(metadata_length));
+        position += 8;
+
+        if (metadata_length == 0)
+        {
+            EXPECT_EQ(position, stream.size());
+            break;
+        }
+
+        uint32_t table;
+        int32_t vtable;
+        uint16_t header_type_field;
+        uint16_t body_length_field;
+        int64_t body_length;
+
+        memcpy(&table, stream.data() + position, sizeof(table));
+        table += position;
+        memcpy(&vtable, stream.data() + table, sizeof(vtable));
+        memcpy(&header_type_field, stream.data() + table - vtable + 4 + 2 * 1, sizeof(header_type_field));
+        memcpy(&body_length_field, stream.data() + table - vtable + 4 + 2 * 3, sizeof(body_length_field));
+        memcpy(&body_length, stream.data() + table + body_length_field, sizeof(body_length));
+
+        header_types.push_back(stream[table + header_type_field]);
+        position += metadata_length + body_length;
+    }
+
+    EXPECT_EQ(header_types, (std::vector<int> {1, 2, 3, 2, 3}));
+}
+
+TEST(KeyValuePairExtractorTests, TypedColumns) {
+    using extractKV::ValueType;
+
+    // Parsers are exact, anything but the expected syntax or out of range values are invalid
+    int64_t integer;
+    EXPECT_TRUE(extractKV::parseInt64("1234567890123456789", integer));
+    EXPECT_EQ(integer, 1234567890123456789);
+    EXPECT_TRUE(extractKV::parseInt64("-9223372036854775808", integer));
+    EXPECT_EQ(integer, std::numeric_limits<int64_t>::min());
+    EXPECT_TRUE(extractKV::parseInt64("+42", integer));
+    EXPECT_EQ(integer, 42);
+    EXPECT_FALSE(extractKV::parseInt64("9223372036854775808", integer));
+    EXPECT_FALSE(extractKV::parseInt64("12345678901234567890", integer));
+    EXPECT_FALSE(extractKV::parseInt64("1234567a", integer));
+    EXPECT_FALSE(extractKV::parseInt64("-", integer));
+    EXPECT_FALSE(extractKV::parseInt64("", integer));
+
+    double floating;
+    EXPECT_TRUE(extractKV::parseDouble("+1.5e3", floating));
+    EXPECT_EQ(floating, 1500.0);
+    EXPECT_FALSE(extractKV::parseDouble("1.5ms", floating));
+    EXPECT_FALSE(extractKV::parseDouble("+-1", floating));
+
+    bool boolean;
+    EXPECT_TRUE(extractKV::parseBool("TRUE", boolean));
+    EXPECT_TRUE(boolean);
+    EXPECT_TRUE(extractKV::parseBool("no", boolean));
+    EXPECT_FALSE(boolean);
+    EXPECT_FALSE(extractKV::parseBool("maybe", boolean));
+
+    int64_t timestamp;
+    EXPECT_TRUE(extractKV::parseTimestamp("2024-02-29T12:34:56.789Z", timestamp));
+    EXPECT_EQ(timestamp, 1709210096789000);
+    EXPECT_TRUE(extractKV::parseTimestamp("2024-02-29 14:34:56.789123456+02:00", timestamp));
+    EXPECT_EQ(timestamp, 1709210096789123);
+    EXPECT_TRUE(extractKV::parseTimestamp("1709210096.5", timestamp));
+    EXPECT_EQ(timestamp, 1709210096500000);
+    EXPECT_TRUE(extractKV::parseTimestamp("1969-12-31", timestamp));
+    EXPECT_EQ(timestamp, -86400000000);
+    EXPECT_FALSE(extractKV::parseTimestamp("2023-02-29", timestamp));
+    EXPECT_FALSE(extractKV::parseTimestamp("2024-02-29T25:00:00", timestamp));
+
+    // Values are parsed during extraction, missing keys and invalid values are null
+    auto extractor = KeyValuePairExtractorBuilder().build();
+
+    extractKV::ColumnarBatch batch({"status", "latency", "cached", "ts", "path"}, {}, extractKV::ColumnarBatch::DEFAULT_MAX_DICTIONARY_SIZE,
+                                   {{"status", ValueType::INT64}, {"latency", ValueType::DOUBLE}, {"cached", ValueType::BOOL},
+                                    {"ts", ValueType::TIMESTAMP}, {"path", ValueType::STRING}});
+
+    for (const auto * row : {"status:200 latency:1.25 cached:true ts:1970-01-01T00:00:01Z path:/",
+                             "status:oops latency:2 cached:false path:/a",
+                             "status:500 status:503 cached:yes ts:2"})
+    {
+        extractor->extract(row, batch);
+    }
+
+    ASSERT_EQ(batch.numberOfRows(), 3u);
+    EXPECT_EQ(batch.getType(4), ValueType::STRING);
+    EXPECT_EQ(batch.getColumn(4).value(1), "/a");
+    EXPECT_THROW(batch.getColumn(0), std::runtime_error);
+
+    const auto & status = batch.getTypedColumn(0);
+    EXPECT_EQ(status.int64At(0), 200);
+    EXPECT_TRUE(status.isNull(1));
+    EXPECT_TRUE(status.isInvalid(1));
+    EXPECT_EQ(status.int64At(2), 503);
+    EXPECT_EQ(status.null_count, 1u);
+    EXPECT_EQ(status.invalid_count, 1u);
+
+    const auto & latency = batch.getTypedColumn(1);
+    EXPECT_EQ(latency.doubleAt(0), 1.25);
+    EXPECT_EQ(latency.doubleAt(1), 2.0);
+    EXPECT_TRUE(latency.isNull(2));
+    EXPECT_FALSE(latency.isInvalid(2));
+
+    const auto & cached = batch.getTypedColumn(2);
+    EXPECT_TRUE(cached.boolAt(0));
+    EXPECT_FALSE(cached.boolAt(1));
+    EXPECT_TRUE(cached.boolAt(2));
+
+    const auto & ts = batch.getTypedColumn(3);
+    EXPECT_EQ(ts.int64At(0), 1000000);
+    EXPECT_TRUE(ts.isNull(1));
+    EXPECT_EQ(ts.int64At(2), 2000000);
+
+    EXPECT_THROW(extractKV::ColumnarBatch({"a"}, {"a"}, 8192, {{"a", ValueType::INT64}}), std::runtime_error);
+    EXPECT_THROW(extractKV::parseValueType("int"), std::runtime_error);
+}
+
+TEST(KeyValuePairExtractorTests, SchemaInference) {
+    using extractKV::ValueType;
+
+    auto extractor = KeyValuePairExtractorBuilder().build();
+    extractKV::ColumnarBatch batch;
+
+    for (size_t row = 0; row < 1000; ++row)
+    {
+        std::string data = "ts:2024-01-01T00:00:00Z level:" + std::string(row % 10 ? "info" : "error")
+            + " status:" + std::to_string(200 + row % 3) + " latency:" + std::to_string(row) + ".5 cached:" + (row % 2 ? "true" : "false")
+            + " user:u" + std::to_string(row);
+
+        if (row % 4 == 0)
+        {
+            data += " trace:";
+        }
+        else if (row % 4 == 1)
+        {
+            data += " trace:t" + std::to_string(row);
+        }
+
+        extractor->extract(data, batch);
+    }
+
+    extractKV::SchemaInference inference;
+    inference.add(batch);
+
+    EXPECT_EQ(inference.numberOfRows(), 1000u);
+
+    const auto columns = inference.getColumns();
+    ASSERT_EQ(columns.size(), 7u);
+
+    std::vector<std::string> keys;
+    std::vector<ValueType> types;
+    std::vector<bool> low_cardinality;
+
+    for (const auto & column : columns)
+    {
+        keys.push_back(column.key);
+        types.push_back(column.type);
+        low_cardinality.push_back(column.low_cardinality);
+    }
+
+    EXPECT_EQ(keys, (std::vector<std::string> {"ts", "level", "status", "latency", "cached", "user", "trace"}));
+    EXPECT_EQ(types, (std::vector<ValueType> {ValueType::TIMESTAMP, ValueType::STRING, ValueType::INT64, ValueType::DOUBLE,
+                                              ValueType::BOOL, ValueType::STRING, ValueType::STRING}));
+    EXPECT_EQ(low_cardinality, (std::vector<bool> {false, true, false, false, false, false, false}));
+
+    // Empty values count towards presence and lengths, not towards the type
+    EXPECT_DOUBLE_EQ(columns[6].presence, 0.5);
+    EXPECT_EQ(columns[6].min_length, 0u);
+    EXPECT_EQ(columns[6].max_length, 4u);
+
+    EXPECT_DOUBLE_EQ(columns[1].presence, 1.0);
+    EXPECT_EQ(columns[1].min_length, 4u);
+    EXPECT_EQ(columns[1].max_length, 5u);
+    EXPECT_NEAR(columns[1].distinct_values, 2, 0.5);
+    EXPECT_NEAR(columns[5].distinct_values, 1000, 50);
+
+    EXPECT_THROW(inference.add(extractKV::ColumnarBatch({"ts"})), std::runtime_error);
+}